@@ -0,0 +1,440 @@
+#include "atlas.h"
+#include "profile.h"
+#include "jobs.h"
+#include "rlgl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ATLAS_PADDING 1
+#define ATLAS_MAX_SIZE 4096
+
+#define ATLAS_PACK_MAGIC 0x534c5441     // "ATLS"
+#define ATLAS_PACK_VERSION 1
+
+#define ATLAS_UPLOAD_ROWS 64        // rows per texture upload step
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    int width;
+    int height;
+    int regionCount;
+} AtlasPackHeader;
+
+typedef struct {
+    float x, y, width, height;
+    char path[128];     // source sprite, to catch a stale sprite table
+} AtlasPackRegion;
+
+const SpriteSource spriteSources[SPRITE_COUNT] = {
+    [SPRITE_KING_IDLE]  = { "Sprites/01-KingHuman/idle.png", 2.0f },
+    [SPRITE_KING_RUN]   = { "Sprites/01-KingHuman/run.png", 2.0f },
+    [SPRITE_KING_JUMP]  = { "Sprites/01-KingHuman/jump.png", 2.0f },
+    [SPRITE_KING_FALL]  = { "Sprites/01-KingHuman/fall.png", 2.0f },
+    [SPRITE_KING_HIT]   = { "Sprites/01-KingHuman/Hit.png", 2.0f },
+    [SPRITE_BACKGROUND] = { "Sprites/Background/Blue.png", 1.0f },
+    [SPRITE_GROUND]     = { "Sprites/ground.png", 2.0f },
+    [SPRITE_PLATFORM]   = { "Sprites/platform.png", 1.0f },
+    [SPRITE_TERRAIN]    = { "Sprites/14-TileSets/Terrain (32x32).png", 1.0f },
+    [SPRITE_DECORATIONS] = { "Sprites/14-TileSets/Decorations (32x32).png", 1.0f },
+    [SPRITE_DIAMOND]    = { "Sprites/Diamond.png", 2.0f },
+    [SPRITE_SPIKEHEAD]  = { "Sprites/enemy/idle.png", 1.5f },
+    [SPRITE_KING_PIG_IDLE]   = { "Sprites/02-King Pig/Idle (38x28).png", 2.0f },
+    [SPRITE_KING_PIG_RUN]    = { "Sprites/02-King Pig/Run (38x28).png", 2.0f },
+    [SPRITE_KING_PIG_JUMP]   = { "Sprites/02-King Pig/Jump (38x28).png", 2.0f },
+    [SPRITE_KING_PIG_FALL]   = { "Sprites/02-King Pig/Fall (38x28).png", 2.0f },
+    [SPRITE_PIG_IDLE]        = { "Sprites/03-Pig/Idle (34x28).png", 2.0f },
+    [SPRITE_PIG_RUN]         = { "Sprites/03-Pig/Run (34x28).png", 2.0f },
+    [SPRITE_PIG_JUMP]        = { "Sprites/03-Pig/Jump (34x28).png", 2.0f },
+    [SPRITE_PIG_FALL]        = { "Sprites/03-Pig/Fall (34x28).png", 2.0f },
+    [SPRITE_BOX_PIG_IDLE]    = { "Sprites/04-Pig Throwing a Box/Idle (26x30).png", 2.0f },
+    [SPRITE_BOX_PIG_RUN]     = { "Sprites/04-Pig Throwing a Box/Run (26x30).png", 2.0f },
+    [SPRITE_BOX_PIG_THROW]   = { "Sprites/04-Pig Throwing a Box/Throwing Box (26x30).png", 2.0f },
+    [SPRITE_BOMB_PIG_IDLE]   = { "Sprites/05-Pig Thowing a Bomb/Idle (26x26).png", 2.0f },
+    [SPRITE_BOMB_PIG_RUN]    = { "Sprites/05-Pig Thowing a Bomb/Run (26x26).png", 2.0f },
+    [SPRITE_BOMB_PIG_THROW]  = { "Sprites/05-Pig Thowing a Bomb/Throwing Boom (26x26).png", 2.0f },
+    [SPRITE_HIDING_PIG_IDLE] = { "Sprites/06-Pig Hide in the Box/Ground (26x20).png", 2.0f },
+    [SPRITE_HIDING_PIG_HOP]  = { "Sprites/06-Pig Hide in the Box/Jump (26x20).png", 2.0f },
+    [SPRITE_HIDING_PIG_FALL] = { "Sprites/06-Pig Hide in the Box/Fall (26x20).png", 2.0f },
+    [SPRITE_HIDING_PIG_LOOK] = { "Sprites/06-Pig Hide in the Box/Looking Out (26x20).png", 2.0f },
+    [SPRITE_CANNON_IDLE]     = { "Sprites/10-Cannon/Idle.png", 2.0f },
+    [SPRITE_CANNON_SHOOT]    = { "Sprites/10-Cannon/Shoot (44x28).png", 2.0f },
+    [SPRITE_CANNON_BALL]     = { "Sprites/10-Cannon/Cannon Ball.png", 2.0f },
+    [SPRITE_BOX]             = { "Sprites/08-Box/Idle.png", 2.0f },
+    [SPRITE_BOMB_ON]         = { "Sprites/09-Bomb/Bomb On (52x56).png", 2.0f },
+    [SPRITE_BOMB_BLAST]      = { "Sprites/09-Bomb/Boooooom (52x56).png", 2.0f },
+    [SPRITE_BOX_PIECE_1] = { "Sprites/08-Box/Box Pieces 1.png", 2.0f },
+    [SPRITE_BOX_PIECE_2] = { "Sprites/08-Box/Box Pieces 2.png", 2.0f },
+    [SPRITE_BOX_PIECE_3] = { "Sprites/08-Box/Box Pieces 3.png", 2.0f },
+    [SPRITE_BOX_PIECE_4] = { "Sprites/08-Box/Box Pieces 4.png", 2.0f },
+};
+
+static void RunSpriteDecodeJob(void *data, int begin, int end)
+{
+    SpriteDecodeJob *job = data;
+    for (int n = begin; n < end; n++) {
+        int i = (job->ids != NULL) ? job->ids[n] : n;
+        Image *image = &job->images[i];
+        *image = LoadImage(spriteSources[i].path);
+        if (image->data != NULL && spriteSources[i].scale != 1.0f)
+            ImageResizeNN(image, image->width*spriteSources[i].scale, image->height*spriteSources[i].scale);
+        if (job->decoded != NULL) __atomic_add_fetch(job->decoded, 1, __ATOMIC_RELEASE);
+    }
+}
+
+bool LoadSpriteImages(Image *images, int *decoded)
+{
+    // One sprite per job, decoded on whichever workers are free
+    JobCounter jobs;
+    SpriteDecodeJob job = { images, NULL, decoded };
+    ParallelFor(&jobs, SPRITE_COUNT, 1, RunSpriteDecodeJob, &job);
+    WaitJobs(&jobs);
+
+    bool ok = true;
+    for (int i = 0; i < SPRITE_COUNT; i++) ok = ok && (images[i].data != NULL);
+    if (!ok) {
+        for (int i = 0; i < SPRITE_COUNT; i++) UnloadImage(images[i]);
+    }
+    return ok;
+}
+
+// Copy an image into the atlas and extrude its outermost pixels into the padding
+static void BlitRegion(Image *atlas, Image image, Rectangle dst)
+{
+    float w = (float)image.width, h = (float)image.height;
+
+    ImageDraw(atlas, image, (Rectangle){ 0, 0, 1, h }, (Rectangle){ dst.x - 1, dst.y, 1, h }, WHITE);
+    ImageDraw(atlas, image, (Rectangle){ w - 1, 0, 1, h }, (Rectangle){ dst.x + w, dst.y, 1, h }, WHITE);
+    ImageDraw(atlas, image, (Rectangle){ 0, 0, w, 1 }, (Rectangle){ dst.x, dst.y - 1, w, 1 }, WHITE);
+    ImageDraw(atlas, image, (Rectangle){ 0, h - 1, w, 1 }, (Rectangle){ dst.x, dst.y + h, w, 1 }, WHITE);
+    ImageDraw(atlas, image, (Rectangle){ 0, 0, w, h }, dst, WHITE);
+}
+
+bool PackAtlas(const Image *images, int count, Image *atlas, Rectangle *regions)
+{
+    // Tallest first keeps the shelves tight
+    int *order = malloc(count*sizeof(int));
+    if (order == NULL) return false;
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && images[order[j - 1]].height < images[i].height) { order[j] = order[j - 1]; j--; }
+        order[j] = i;
+    }
+
+    bool packed = false;
+    int size = 256;
+    int usedHeight = 0;
+
+    for (; size <= ATLAS_MAX_SIZE && !packed; size *= 2) {
+        int x = 0, y = 0, shelf = 0;
+        packed = true;
+
+        for (int k = 0; k < count; k++) {
+            const Image *image = &images[order[k]];
+            int w = image->width + 2*ATLAS_PADDING;
+            int h = image->height + 2*ATLAS_PADDING;
+
+            if (x + w > size) { x = 0; y += shelf; shelf = 0; }
+            if (w > size || y + h > size) { packed = false; break; }
+
+            regions[order[k]] = (Rectangle){ x + ATLAS_PADDING, y + ATLAS_PADDING, image->width, image->height };
+            x += w;
+            if (h > shelf) shelf = h;
+        }
+        usedHeight = y + shelf;
+        if (packed) break;
+    }
+
+    free(order);
+    if (!packed) return false;
+
+    *atlas = GenImageColor(size, usedHeight, BLANK);
+    for (int i = 0; i < count; i++) BlitRegion(atlas, images[i], regions[i]);
+
+    return true;
+}
+
+bool SaveAtlasPack(Image atlas, const Rectangle *regions)
+{
+    if (atlas.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return false;
+
+    int pixelSize = atlas.width*atlas.height*4;
+    int size = sizeof(AtlasPackHeader) + SPRITE_COUNT*sizeof(AtlasPackRegion) + pixelSize;
+    unsigned char *data = calloc(size, 1);
+    if (data == NULL) return false;
+
+    AtlasPackHeader *header = (AtlasPackHeader *)data;
+    *header = (AtlasPackHeader){ ATLAS_PACK_MAGIC, ATLAS_PACK_VERSION, atlas.width, atlas.height, SPRITE_COUNT };
+
+    AtlasPackRegion *packRegions = (AtlasPackRegion *)(header + 1);
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        packRegions[i].x = regions[i].x;
+        packRegions[i].y = regions[i].y;
+        packRegions[i].width = regions[i].width;
+        packRegions[i].height = regions[i].height;
+        strncpy(packRegions[i].path, spriteSources[i].path, sizeof(packRegions[i].path) - 1);
+    }
+
+    memcpy(packRegions + SPRITE_COUNT, atlas.data, pixelSize);
+
+    bool ok = SaveFileData(ATLAS_PACK_PATH, data, size);
+    free(data);
+    return ok;
+}
+
+// The baked pack is stale once any source sprite may be newer
+static bool IsAtlasPackFresh(void)
+{
+    if (!FileExists(ATLAS_PACK_PATH)) return false;
+
+    long packTime = GetFileModTime(ATLAS_PACK_PATH);
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        // Modification times have one second resolution: a sprite saved
+        // in the same second as the bake may be newer
+        if (GetFileModTime(spriteSources[i].path) >= packTime) return false;
+    }
+    return true;
+}
+
+// Read and validate the baked pack. On success the loader's pixels point
+// into packData, ready to upload as they are: no decode, no resize.
+static bool ReadAtlasPack(AtlasLoader *loader)
+{
+    int size = 0;
+    unsigned char *data = LoadFileData(ATLAS_PACK_PATH, &size);
+    if (data == NULL) return false;
+
+    bool ok = false;
+    const AtlasPackHeader *header = (const AtlasPackHeader *)data;
+    const AtlasPackRegion *packRegions = (const AtlasPackRegion *)(header + 1);
+
+    // Bound the dimensions before they size anything
+    if (size >= (int)sizeof(AtlasPackHeader) && header->magic == ATLAS_PACK_MAGIC &&
+        header->version == ATLAS_PACK_VERSION && header->regionCount == SPRITE_COUNT &&
+        header->width > 0 && header->width <= ATLAS_MAX_SIZE &&
+        header->height > 0 && header->height <= ATLAS_MAX_SIZE &&
+        (size_t)size == sizeof(AtlasPackHeader) + SPRITE_COUNT*sizeof(AtlasPackRegion) + (size_t)header->width*header->height*4) {
+        ok = true;
+        for (int i = 0; i < SPRITE_COUNT && ok; i++) {
+            ok = (strncmp(packRegions[i].path, spriteSources[i].path, sizeof(packRegions[i].path)) == 0);
+            loader->atlas.regions[i] = (Rectangle){ packRegions[i].x, packRegions[i].y, packRegions[i].width, packRegions[i].height };
+        }
+    }
+
+    if (!ok) {
+        UnloadFileData(data);
+        return false;
+    }
+
+    loader->packData = data;
+    loader->pixels = (Image){
+        .data = (void *)(packRegions + SPRITE_COUNT),
+        .width = header->width,
+        .height = header->height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+    return true;
+}
+
+// Loader thread: produce the packed pixels, the GL thread uploads them
+static void *AtlasLoaderMain(void *arg)
+{
+    AtlasLoader *loader = arg;
+    SetProfileThread(PROFILE_THREAD_LOADER);
+    AttachJobThread();
+    PROFILE_BEGIN(PROFILE_LOAD_IMAGES);
+
+    bool ok = IsAtlasPackFresh() && ReadAtlasPack(loader);
+    if (ok) {
+        __atomic_store_n(&loader->decoded, SPRITE_COUNT, __ATOMIC_RELEASE);
+    } else {
+        TraceLog(LOG_INFO, "ATLAS: No baked pack, packing sprites at startup");
+
+        Image images[SPRITE_COUNT];
+        if (LoadSpriteImages(images, &loader->decoded)) {
+            ok = PackAtlas(images, SPRITE_COUNT, &loader->pixels, loader->atlas.regions);
+            if (!ok) TraceLog(LOG_WARNING, "ATLAS: Sprites do not fit in %ix%i", ATLAS_MAX_SIZE, ATLAS_MAX_SIZE);
+            for (int i = 0; i < SPRITE_COUNT; i++) UnloadImage(images[i]);
+        } else {
+            TraceLog(LOG_WARNING, "ATLAS: Failed to load sprite sources");
+        }
+    }
+
+    PROFILE_END(PROFILE_LOAD_IMAGES);
+    DetachJobThread();
+    __atomic_store_n(&loader->state, ok ? ATLAS_LOAD_UPLOADING : ATLAS_LOAD_FAILED, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+void StartAtlasLoad(AtlasLoader *loader)
+{
+    *loader = (AtlasLoader){ .state = ATLAS_LOAD_DECODING };
+    if (pthread_create(&loader->thread, NULL, AtlasLoaderMain, loader) != 0) {
+        TraceLog(LOG_WARNING, "ATLAS: Failed to start the loader thread");
+        loader->state = ATLAS_LOAD_FAILED;
+        return;
+    }
+    loader->threadRunning = true;
+}
+
+static void FinishAtlasLoad(AtlasLoader *loader, AtlasLoadState state)
+{
+    if (loader->packData != NULL) UnloadFileData(loader->packData);
+    else if (loader->pixels.data != NULL) UnloadImage(loader->pixels);
+    loader->packData = NULL;
+    loader->pixels = (Image){ 0 };
+    loader->state = state;
+}
+
+bool UpdateAtlasLoad(AtlasLoader *loader, double budget)
+{
+    int state = __atomic_load_n(&loader->state, __ATOMIC_ACQUIRE);
+    if (state == ATLAS_LOAD_DECODING) return false;
+
+    if (loader->threadRunning) {
+        pthread_join(loader->thread, NULL);
+        loader->threadRunning = false;
+    }
+    if (state != ATLAS_LOAD_UPLOADING) return true;
+
+    // Upload in horizontal bands until the frame's budget is spent
+    double deadline = GetProfileTime() + budget;
+    const Image *pixels = &loader->pixels;
+    Texture2D *texture = &loader->atlas.texture;
+
+    PROFILE_BEGIN(PROFILE_UPLOAD_TEXTURES);
+    if (texture->id == 0) {
+        texture->id = rlLoadTexture(NULL, pixels->width, pixels->height, pixels->format, 1);
+        texture->width = pixels->width;
+        texture->height = pixels->height;
+        texture->mipmaps = 1;
+        texture->format = pixels->format;
+    }
+    while (texture->id > 0 && loader->uploadedRows < pixels->height && GetProfileTime() < deadline) {
+        int rows = pixels->height - loader->uploadedRows;
+        if (rows > ATLAS_UPLOAD_ROWS) rows = ATLAS_UPLOAD_ROWS;
+        const unsigned char *band = (const unsigned char *)pixels->data + (size_t)loader->uploadedRows*pixels->width*4;
+        UpdateTextureRec(*texture, (Rectangle){ 0, loader->uploadedRows, pixels->width, rows }, band);
+        loader->uploadedRows += rows;
+    }
+    PROFILE_END(PROFILE_UPLOAD_TEXTURES);
+
+    if (texture->id == 0) {
+        FinishAtlasLoad(loader, ATLAS_LOAD_FAILED);
+        return true;
+    }
+    if (loader->uploadedRows < pixels->height) return false;
+
+    FinishAtlasLoad(loader, ATLAS_LOAD_DONE);
+    return true;
+}
+
+void CancelAtlasLoad(AtlasLoader *loader)
+{
+    if (loader->threadRunning) {
+        pthread_join(loader->thread, NULL);
+        loader->threadRunning = false;
+    }
+    if (loader->state == ATLAS_LOAD_DONE) return;
+
+    if (loader->atlas.texture.id > 0) UnloadTexture(loader->atlas.texture);
+    loader->atlas.texture = (Texture2D){ 0 };
+    FinishAtlasLoad(loader, ATLAS_LOAD_FAILED);
+}
+
+float GetAtlasLoadProgress(const AtlasLoader *loader)
+{
+    // Decoding and uploading count half each. The pixels belong to the
+    // loader thread until it publishes the uploading state.
+    int state = __atomic_load_n(&loader->state, __ATOMIC_ACQUIRE);
+    if (state == ATLAS_LOAD_DONE || state == ATLAS_LOAD_FAILED) return 1.0f;
+
+    float decoded = (float)__atomic_load_n(&loader->decoded, __ATOMIC_ACQUIRE)/SPRITE_COUNT;
+    float uploaded = 0.0f;
+    if (state == ATLAS_LOAD_UPLOADING && loader->pixels.height > 0)
+        uploaded = (float)loader->uploadedRows/loader->pixels.height;
+    return 0.5f*decoded + 0.5f*uploaded;
+}
+
+void UnloadAtlas(Atlas atlas)
+{
+    UnloadTexture(atlas.texture);
+}
+
+bool InitAtlasReloader(AtlasReloader *reloader)
+{
+    *reloader = (AtlasReloader){ 0 };
+
+    const char *paths[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; i++) paths[i] = spriteSources[i].path;
+    return InitFileWatcher(&reloader->watcher, paths, SPRITE_COUNT);
+}
+
+void UnloadAtlasReloader(AtlasReloader *reloader)
+{
+    if (reloader->decodeCount > 0) {
+        WaitJobs(&reloader->jobs);
+        for (int n = 0; n < reloader->decodeCount; n++) UnloadImage(reloader->images[reloader->decodeIds[n]]);
+    }
+    CloseFileWatcher(&reloader->watcher);
+}
+
+// Replace one region in place, border extrusion included
+static void PatchAtlasRegion(Atlas *atlas, SpriteId id, Image image)
+{
+    Rectangle region = atlas->regions[id];
+    Image padded = GenImageColor(image.width + 2*ATLAS_PADDING, image.height + 2*ATLAS_PADDING, BLANK);
+    BlitRegion(&padded, image, (Rectangle){ ATLAS_PADDING, ATLAS_PADDING, image.width, image.height });
+    UpdateTextureRec(atlas->texture, (Rectangle){ region.x - ATLAS_PADDING, region.y - ATLAS_PADDING,
+                                                  padded.width, padded.height }, padded.data);
+    UnloadImage(padded);
+}
+
+int UpdateAtlasReloader(AtlasReloader *reloader, Atlas *atlas, bool *patched, bool *resized)
+{
+    bool changed[SPRITE_COUNT];
+    if (PollFileWatcher(&reloader->watcher, changed) > 0) {
+        for (int i = 0; i < SPRITE_COUNT; i++) reloader->queued[i] = reloader->queued[i] || changed[i];
+    }
+
+    int patchedCount = 0;
+    for (int i = 0; i < SPRITE_COUNT; i++) { patched[i] = false; resized[i] = false; }
+
+    // Finished decodes: patch the regions whose size did not change
+    if (reloader->decodeCount > 0) {
+        if (!IsJobDone(&reloader->jobs)) return 0;
+
+        for (int n = 0; n < reloader->decodeCount; n++) {
+            int id = reloader->decodeIds[n];
+            Image image = reloader->images[id];
+            if (image.data == NULL) {
+                TraceLog(LOG_WARNING, "ATLAS: [%s] Failed to reload sprite", spriteSources[id].path);
+            } else if (image.width != (int)atlas->regions[id].width || image.height != (int)atlas->regions[id].height) {
+                resized[id] = true;
+            } else {
+                PatchAtlasRegion(atlas, id, image);
+                TraceLog(LOG_INFO, "ATLAS: [%s] Sprite reloaded", spriteSources[id].path);
+                patched[id] = true;
+                patchedCount++;
+            }
+            UnloadImage(image);
+        }
+        reloader->decodeCount = 0;
+    }
+
+    // Start decoding whatever changed since, on the job workers
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        if (!reloader->queued[i]) continue;
+        reloader->queued[i] = false;
+        reloader->images[i] = (Image){ 0 };
+        reloader->decodeIds[reloader->decodeCount++] = i;
+    }
+    if (reloader->decodeCount > 0) {
+        reloader->decodeJob = (SpriteDecodeJob){ reloader->images, reloader->decodeIds, NULL };
+        ParallelFor(&reloader->jobs, reloader->decodeCount, 1, RunSpriteDecodeJob, &reloader->decodeJob);
+    }
+
+    return patchedCount;
+}
@@ -0,0 +1,144 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "raylib.h"
+#include "filewatch.h"
+#include "jobs.h"
+
+#include <pthread.h>
+
+// Every sprite the game draws, packed into one texture so the world
+// renders in a single batch
+typedef enum {
+    SPRITE_KING_IDLE,
+    SPRITE_KING_RUN,
+    SPRITE_KING_JUMP,
+    SPRITE_KING_FALL,
+    SPRITE_KING_HIT,
+    SPRITE_BACKGROUND,
+    SPRITE_GROUND,
+    SPRITE_PLATFORM,
+    SPRITE_TERRAIN,         // 32x32 tilesets, see TILE_SIZE
+    SPRITE_DECORATIONS,
+    SPRITE_DIAMOND,
+    SPRITE_SPIKEHEAD,
+    SPRITE_KING_PIG_IDLE,   // enemies, see enemySprites in render.c
+    SPRITE_KING_PIG_RUN,
+    SPRITE_KING_PIG_JUMP,
+    SPRITE_KING_PIG_FALL,
+    SPRITE_PIG_IDLE,
+    SPRITE_PIG_RUN,
+    SPRITE_PIG_JUMP,
+    SPRITE_PIG_FALL,
+    SPRITE_BOX_PIG_IDLE,
+    SPRITE_BOX_PIG_RUN,
+    SPRITE_BOX_PIG_THROW,
+    SPRITE_BOMB_PIG_IDLE,
+    SPRITE_BOMB_PIG_RUN,
+    SPRITE_BOMB_PIG_THROW,
+    SPRITE_HIDING_PIG_IDLE,
+    SPRITE_HIDING_PIG_HOP,
+    SPRITE_HIDING_PIG_FALL,
+    SPRITE_HIDING_PIG_LOOK,
+    SPRITE_CANNON_IDLE,     // cannons and projectiles, see projectileSprites in render.c
+    SPRITE_CANNON_SHOOT,
+    SPRITE_CANNON_BALL,
+    SPRITE_BOX,
+    SPRITE_BOMB_ON,
+    SPRITE_BOMB_BLAST,
+    SPRITE_BOX_PIECE_1,     // debris particles, four variants in a row
+    SPRITE_BOX_PIECE_2,
+    SPRITE_BOX_PIECE_3,
+    SPRITE_BOX_PIECE_4,
+    SPRITE_COUNT
+} SpriteId;
+
+typedef struct {
+    const char *path;
+    float scale;        // applied when packing
+} SpriteSource;
+
+extern const SpriteSource spriteSources[SPRITE_COUNT];
+
+typedef struct {
+    Texture2D texture;
+    Rectangle regions[SPRITE_COUNT];
+} Atlas;
+
+// Baked atlas: header, region table and raw RGBA8 pixels ready for upload
+#define ATLAS_PACK_PATH "Sprites/atlas.pack"
+
+// Load and scale (nearest neighbour) every sprite source, decoding them in
+// parallel on the job system. decoded (may be NULL) counts finished sprites.
+// Returns false if one is missing.
+bool LoadSpriteImages(Image *images, int *decoded);
+
+// Shelf-pack images into one RGBA image. Each region gets a 1 px
+// extruded border so filtering never samples a neighbour.
+bool PackAtlas(const Image *images, int count, Image *atlas, Rectangle *regions);
+
+// Write a packed atlas as a baked pack file (used by tools/bake_assets.c)
+bool SaveAtlasPack(Image atlas, const Rectangle *regions);
+
+// Background atlas load. A loader thread reads the baked pack written by
+// tools/bake_assets.c, or decodes and packs the sprites when the pack is
+// missing or out of date. The GL thread then uploads the pixels a few rows
+// at a time, so the window keeps drawing while assets arrive.
+typedef enum {
+    ATLAS_LOAD_DECODING,
+    ATLAS_LOAD_UPLOADING,
+    ATLAS_LOAD_DONE,
+    ATLAS_LOAD_FAILED
+} AtlasLoadState;
+
+typedef struct {
+    pthread_t thread;
+    bool threadRunning;
+    int state;                  // AtlasLoadState, handed over by the loader thread
+    int decoded;                // sprites decoded so far
+    unsigned char *packData;    // baked pack file, pixels point into it
+    Image pixels;               // packed RGBA8 atlas waiting for upload
+    int uploadedRows;
+    Atlas atlas;                // complete once the state is ATLAS_LOAD_DONE
+} AtlasLoader;
+
+void StartAtlasLoad(AtlasLoader *loader);
+
+// Upload on the GL thread for at most budget seconds. Returns true once
+// the load has finished: the atlas is ready, or failed with texture.id 0.
+bool UpdateAtlasLoad(AtlasLoader *loader, double budget);
+float GetAtlasLoadProgress(const AtlasLoader *loader);
+
+// Abandon an unfinished load: wait for the loader thread and free whatever
+// it produced. A finished atlas is left to its owner.
+void CancelAtlasLoad(AtlasLoader *loader);
+
+void UnloadAtlas(Atlas atlas);
+
+typedef struct {
+    Image *images;
+    const int *ids;     // sprites to decode, NULL for all of them in order
+    int *decoded;
+} SpriteDecodeJob;
+
+// Hot reload: watches the sprite sources and re-decodes only the changed
+// ones on the job workers, then patches their atlas regions in place.
+typedef struct {
+    FileWatcher watcher;
+    bool queued[SPRITE_COUNT];      // changed, waiting for the next decode
+    Image images[SPRITE_COUNT];
+    int decodeIds[SPRITE_COUNT];
+    int decodeCount;                // sprites in the running decode
+    SpriteDecodeJob decodeJob;
+    JobCounter jobs;
+} AtlasReloader;
+
+bool InitAtlasReloader(AtlasReloader *reloader);
+void UnloadAtlasReloader(AtlasReloader *reloader);
+
+// Poll once per frame on the GL thread. Sets patched[i] for every region
+// updated in place and resized[i] for sprites whose new size no longer
+// fits their region (those need a full repack). Returns the patch count.
+int UpdateAtlasReloader(AtlasReloader *reloader, Atlas *atlas, bool *patched, bool *resized);
+
+#endif
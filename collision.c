@@ -0,0 +1,177 @@
+#include "collision.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cell range covered by a rectangle, clamped to the grid
+static void GetCellRange(const SpatialGrid *grid, Rectangle rec, int *x0, int *y0, int *x1, int *y1)
+{
+    *x0 = (int)floorf((rec.x - grid->origin.x)/grid->cellSize);
+    *y0 = (int)floorf((rec.y - grid->origin.y)/grid->cellSize);
+    *x1 = (int)floorf((rec.x + rec.width - grid->origin.x)/grid->cellSize);
+    *y1 = (int)floorf((rec.y + rec.height - grid->origin.y)/grid->cellSize);
+
+    if (*x0 < 0) *x0 = 0;
+    if (*y0 < 0) *y0 = 0;
+    if (*x1 > grid->cols - 1) *x1 = grid->cols - 1;
+    if (*y1 > grid->rows - 1) *y1 = grid->rows - 1;
+}
+
+bool BuildSpatialGrid(SpatialGrid *grid, Arena *arena, const Rectangle *rects, int count, float cellSize)
+{
+    *grid = (SpatialGrid){ 0 };
+    grid->cellSize = cellSize;
+    grid->itemCount = count;
+    if (count <= 0) return true;
+
+    // Grid bounds are the union of all rectangles
+    float minX = rects[0].x, minY = rects[0].y;
+    float maxX = rects[0].x + rects[0].width, maxY = rects[0].y + rects[0].height;
+    for (int i = 1; i < count; i++) {
+        if (rects[i].x < minX) minX = rects[i].x;
+        if (rects[i].y < minY) minY = rects[i].y;
+        if (rects[i].x + rects[i].width > maxX) maxX = rects[i].x + rects[i].width;
+        if (rects[i].y + rects[i].height > maxY) maxY = rects[i].y + rects[i].height;
+    }
+
+    grid->origin = (Vector2){ minX, minY };
+    grid->cols = (int)((maxX - minX)/cellSize) + 1;
+    grid->rows = (int)((maxY - minY)/cellSize) + 1;
+
+    int cellCount = grid->cols*grid->rows;
+    grid->cellStart = ArenaAlloc(arena, (cellCount + 1)*sizeof(int));
+    grid->stamp = ArenaAlloc(arena, count*sizeof(int));
+    if (grid->cellStart == NULL || grid->stamp == NULL) return false;
+
+    // Count pass: how many items land in each cell
+    for (int i = 0; i < count; i++) {
+        int x0, y0, x1, y1;
+        GetCellRange(grid, rects[i], &x0, &y0, &x1, &y1);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) grid->cellStart[y*grid->cols + x + 1]++;
+    }
+
+    for (int c = 0; c < cellCount; c++) grid->cellStart[c + 1] += grid->cellStart[c];
+
+    // Fill pass, items stay in index order within a cell. The cursors are
+    // scratch memory, released again once the grid is built.
+    grid->items = ArenaAlloc(arena, grid->cellStart[cellCount]*sizeof(int));
+    ArenaMark scratch = GetArenaMark(arena);
+    int *fill = ArenaAlloc(arena, cellCount*sizeof(int));
+    if (grid->items == NULL || fill == NULL) return false;
+    for (int c = 0; c < cellCount; c++) fill[c] = grid->cellStart[c];
+
+    for (int i = 0; i < count; i++) {
+        int x0, y0, x1, y1;
+        GetCellRange(grid, rects[i], &x0, &y0, &x1, &y1);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) grid->items[fill[y*grid->cols + x]++] = i;
+    }
+
+    ResetArena(arena, scratch);
+    return true;
+}
+
+int QuerySpatialGrid(SpatialGrid *grid, Rectangle area, int *results, int maxResults)
+{
+    if (grid->itemCount <= 0) return 0;
+
+    int x0, y0, x1, y1;
+    GetCellRange(grid, area, &x0, &y0, &x1, &y1);
+    if (x0 > x1 || y0 > y1) return 0;
+
+    grid->queryStamp++;
+    int found = 0;
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int c = y*grid->cols + x;
+            for (int k = grid->cellStart[c]; k < grid->cellStart[c + 1]; k++) {
+                int item = grid->items[k];
+                if (grid->stamp[item] == grid->queryStamp) continue;
+                grid->stamp[item] = grid->queryStamp;
+                if (found == maxResults) return found;
+                results[found++] = item;
+            }
+        }
+    }
+
+    return found;
+}
+
+// Time interval during which two 1D spans overlap while one moves by d
+static void SweepAxis(float pos, float size, float d, float targetPos, float targetSize, float *entry, float *exit)
+{
+    if (d > 0) {
+        *entry = (targetPos - (pos + size))/d;
+        *exit = (targetPos + targetSize - pos)/d;
+    } else if (d < 0) {
+        *entry = (targetPos + targetSize - pos)/d;
+        *exit = (targetPos - (pos + size))/d;
+    } else if (pos < targetPos + targetSize && pos + size > targetPos) {
+        *entry = -INFINITY;
+        *exit = INFINITY;
+    } else {
+        *entry = INFINITY;
+        *exit = -INFINITY;
+    }
+}
+
+// By top edge, then left edge
+static int CompareTopLeft(const void *a, const void *b)
+{
+    const Rectangle *ra = a, *rb = b;
+    if (ra->y != rb->y) return (ra->y < rb->y) ? -1 : 1;
+    if (ra->x != rb->x) return (ra->x < rb->x) ? -1 : 1;
+    return 0;
+}
+
+int MergeOneWayPlatforms(const Rectangle *rects, int count, Rectangle *merged)
+{
+    if (count <= 0) return 0;
+
+    memcpy(merged, rects, count*sizeof(Rectangle));
+    qsort(merged, count, sizeof(Rectangle), CompareTopLeft);
+
+    // Sweep each top line left to right, growing the current span while the
+    // next platform starts inside or right at its end
+    int mergedCount = 1;
+    for (int i = 1; i < count; i++) {
+        Rectangle *last = &merged[mergedCount - 1];
+        Rectangle next = merged[i];
+
+        if (next.y == last->y && next.x <= last->x + last->width) {
+            float right = fmaxf(last->x + last->width, next.x + next.width);
+            last->width = right - last->x;
+            last->height = fmaxf(last->height, next.height);
+        } else {
+            merged[mergedCount++] = next;
+        }
+    }
+    return mergedCount;
+}
+
+bool OverlapRects(Rectangle a, Rectangle b)
+{
+    return (a.x < b.x + b.width) && (a.x + a.width > b.x) &&
+           (a.y < b.y + b.height) && (a.y + a.height > b.y);
+}
+
+bool SweepRects(Rectangle moving, Vector2 delta, Rectangle target, float *toi, Vector2 *normal)
+{
+    float xEntry, xExit, yEntry, yExit;
+    SweepAxis(moving.x, moving.width, delta.x, target.x, target.width, &xEntry, &xExit);
+    SweepAxis(moving.y, moving.height, delta.y, target.y, target.height, &yEntry, &yExit);
+
+    float entry = (xEntry > yEntry) ? xEntry : yEntry;
+    float exit = (xExit < yExit) ? xExit : yExit;
+
+    if (entry >= exit || entry < 0.0f || entry > 1.0f) return false;
+
+    *toi = entry;
+    if (xEntry > yEntry) *normal = (Vector2){ (delta.x > 0) ? -1.0f : 1.0f, 0.0f };
+    else *normal = (Vector2){ 0.0f, (delta.y > 0) ? -1.0f : 1.0f };
+
+    return true;
+}
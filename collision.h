@@ -0,0 +1,47 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "raylib.h"
+#include "memory.h"
+
+// Uniform grid over static rectangles, built once when the level loads.
+// Cells are stored CSR style: the items of cell c are
+// items[cellStart[c] .. cellStart[c + 1]). The arrays live in the arena
+// passed to BuildSpatialGrid and go away with it.
+typedef struct {
+    Vector2 origin;
+    float cellSize;
+    int cols;
+    int rows;
+    int *cellStart;
+    int *items;
+    int itemCount;
+    int *stamp;         // last query that returned each item, for dedup
+    int queryStamp;
+} SpatialGrid;
+
+// Returns false when the arena is out of memory
+bool BuildSpatialGrid(SpatialGrid *grid, Arena *arena, const Rectangle *rects, int count, float cellSize);
+
+// Collect the indices of all rectangles whose cells touch area.
+// Each index is reported once; returns the number written to results.
+int QuerySpatialGrid(SpatialGrid *grid, Rectangle area, int *results, int maxResults);
+
+// Merge one-way platforms into as few rectangles as possible. Only the top
+// face of a one-way platform stops anything, so platforms whose tops lie on
+// the same line and whose x ranges overlap or touch land the player exactly
+// like their union does. Writes up to count rectangles to merged (which may
+// not alias rects) and returns how many.
+int MergeOneWayPlatforms(const Rectangle *rects, int count, Rectangle *merged);
+
+// Same test as raylib's CheckCollisionRecs, kept here so the
+// simulation links without raylib (see tools/bench_sim.c)
+bool OverlapRects(Rectangle a, Rectangle b);
+
+// Swept AABB: move `moving` by delta against a static target.
+// On a hit returns true with the fraction of delta travelled before
+// contact (0..1) and the normal of the face that was hit.
+// Rectangles that already overlap at the start do not report a hit.
+bool SweepRects(Rectangle moving, Vector2 delta, Rectangle target, float *toi, Vector2 *normal);
+
+#endif
@@ -0,0 +1,306 @@
+#include "enemies.h"
+
+#include <math.h>
+
+#define ENEMY_TAKEOFF_SLACK 4.0f    // how close to an edge's takeoff x counts as there
+#define ENEMY_MAX_NEARBY 64
+
+// Speeds in px/s, ranges in px, times in seconds
+const EnemyDesc enemyDescs[ENEMY_KIND_COUNT] = {
+    //                   width height patrol chase  range  sight  height  throw  time  cooldown hide   time
+    [ENEMY_KING_PIG]   = { 40, 44,     60.0f, 200.0f, 448.0f, 400.0f, 320.0f,   0.0f, 0.0f, 0.0f,   0.0f, 0.0f,
+                           ENEMY_CHASES | ENEMY_NAVIGATES, 0 },
+    [ENEMY_PIG]        = { 36, 36,     80.0f, 180.0f, 320.0f, 320.0f, 320.0f,   0.0f, 0.0f, 0.0f,   0.0f, 0.0f,
+                           ENEMY_CHASES | ENEMY_NAVIGATES, 0 },
+    [ENEMY_BOX_PIG]    = { 32, 44,     60.0f, 140.0f, 256.0f, 420.0f, 160.0f, 360.0f, 0.5f, 1.5f,   0.0f, 0.0f,
+                           ENEMY_CHASES | ENEMY_THROWS, PROJECTILE_BOX },
+    [ENEMY_BOMB_PIG]   = { 32, 40,     60.0f,   0.0f, 192.0f, 480.0f, 160.0f, 440.0f, 0.5f, 2.5f,   0.0f, 0.0f,
+                           ENEMY_THROWS, PROJECTILE_BOMB },
+    [ENEMY_HIDING_PIG] = { 40, 36,     50.0f,   0.0f, 192.0f, 300.0f, 160.0f,   0.0f, 0.0f, 0.0f, 200.0f, 1.5f,
+                           ENEMY_HIDES, 0 },
+};
+
+bool AreEnemyRangesValid(void)
+{
+    for (int k = 0; k < ENEMY_KIND_COUNT; k++) {
+        const EnemyDesc *desc = &enemyDescs[k];
+        if (desc->range + ENEMY_MAX_OVERSTEP*desc->width >= LEVEL_CHUNK_WIDTH) return false;
+    }
+    return true;
+}
+
+bool AllocEnemies(Enemies *enemies, Arena *arena, int count)
+{
+    *enemies = (Enemies){ 0 };
+
+    // float and int columns are both 4 bytes wide
+    float *block = ArenaAlloc(arena, 14*(count > 0 ? count : 1)*sizeof(float));
+    if (block == NULL) return false;
+
+    enemies->x = block;
+    enemies->y = enemies->x + count;
+    enemies->prevX = enemies->y + count;
+    enemies->prevY = enemies->prevX + count;
+    enemies->vx = enemies->prevY + count;
+    enemies->vy = enemies->vx + count;
+    enemies->homeX = enemies->vy + count;
+    enemies->timer = enemies->homeX + count;
+    enemies->cooldown = enemies->timer + count;
+    enemies->kind = (int *)(enemies->cooldown + count);
+    enemies->state = enemies->kind + count;
+    enemies->facing = enemies->state + count;
+    enemies->platform = enemies->facing + count;
+    enemies->navTarget = enemies->platform + count;
+    enemies->count = count;
+    return true;
+}
+
+void ResetEnemies(Enemies *enemies, const LevelEnemy *spawns)
+{
+    for (int i = 0; i < enemies->count; i++) {
+        enemies->x[i] = spawns[i].x;
+        enemies->y[i] = spawns[i].y;
+        enemies->prevX[i] = spawns[i].x;
+        enemies->prevY[i] = spawns[i].y;
+        enemies->vx[i] = 0.0f;
+        enemies->vy[i] = 0.0f;
+        enemies->homeX[i] = spawns[i].x;
+        enemies->timer[i] = 0.0f;
+        enemies->cooldown[i] = 0.0f;
+        enemies->kind[i] = spawns[i].kind;
+        enemies->state[i] = ENEMY_FALL;
+        enemies->facing[i] = -1;
+        enemies->platform[i] = -1;
+        enemies->navTarget[i] = -1;
+    }
+}
+
+static void SetState(Enemies *enemies, int i, EnemyState state)
+{
+    enemies->state[i] = state;
+    enemies->timer[i] = 0.0f;
+}
+
+// Gravity and a swept landing test, like the player's. An enemy headed
+// for a span drifts toward it until it is above it. Drift (a jump, a
+// blast) stops at the ends of the enemy's range, so it never lands
+// outside it.
+static void Fall(Enemies *enemies, int i, const EnemyDesc *desc, const EnemyUpdate *update, float dt)
+{
+    if (enemies->y[i] > update->worldHeight) return;
+
+    int target = enemies->navTarget[i];
+    if (target >= 0) {
+        const NavSpan *span = &update->nav->spans[target];
+        float centerX = enemies->x[i] + desc->width/2;
+        if (centerX >= span->x0 && centerX <= span->x1) enemies->vx[i] = 0.0f;
+    }
+
+    enemies->vy[i] += update->gravity*dt;
+    float dx = enemies->vx[i]*dt;
+    float dy = enemies->vy[i]*dt;
+
+    float toLo = enemies->homeX[i] - desc->range - enemies->x[i];
+    float toHi = enemies->homeX[i] + desc->range - enemies->x[i];
+    if (dx < 0 && dx <= toLo) { dx = fminf(toLo, 0.0f); enemies->vx[i] = 0.0f; }
+    else if (dx > 0 && dx >= toHi) { dx = fmaxf(toHi, 0.0f); enemies->vx[i] = 0.0f; }
+    Rectangle body = { enemies->x[i], enemies->y[i], desc->width, desc->height };
+    Rectangle swept = {
+        (dx < 0) ? body.x + dx : body.x, (dy < 0) ? body.y + dy : body.y,
+        body.width + fabsf(dx), body.height + fabsf(dy)
+    };
+
+    int nearby[ENEMY_MAX_NEARBY];
+    int nearbyCount = QuerySpatialGrid(update->platformGrid, swept, nearby, ENEMY_MAX_NEARBY);
+
+    float landingTime = 1.0f;
+    int landing = -1;
+    for (int n = 0; n < nearbyCount; n++) {
+        float toi;
+        Vector2 normal;
+        if (SweepRects(body, (Vector2){ dx, dy }, update->platforms[nearby[n]], &toi, &normal) &&
+            normal.y < 0 && toi <= landingTime) {
+            landingTime = toi;
+            landing = nearby[n];
+        }
+    }
+
+    enemies->x[i] += dx;
+    if (landing < 0) {
+        enemies->y[i] += dy;
+        return;
+    }
+
+    enemies->y[i] = update->platforms[landing].y - desc->height;
+    enemies->vx[i] = 0.0f;
+    enemies->vy[i] = 0.0f;
+    enemies->platform[i] = landing;
+    enemies->navTarget[i] = -1;
+    SetState(enemies, i, ENEMY_PATROL);
+}
+
+// Pick the next state from what the enemy sees: dx is the horizontal
+// distance to the player, seen whether it noticed the player at all
+static void Think(Enemies *enemies, int i, const EnemyDesc *desc, float dx, bool seen, EnemyUpdate *update)
+{
+    const unsigned int behaviours = desc->behaviours;
+    const int toPlayer = (dx < 0) ? -1 : 1;
+
+    switch (enemies->state[i]) {
+        case ENEMY_PATROL:
+        case ENEMY_CHASE:
+            if (!seen) {
+                if (enemies->state[i] == ENEMY_CHASE) SetState(enemies, i, ENEMY_PATROL);
+            } else if ((behaviours & ENEMY_HIDES) && fabsf(dx) <= desc->hideRange) {
+                SetState(enemies, i, ENEMY_HIDE);
+            } else if ((behaviours & ENEMY_THROWS) && fabsf(dx) <= desc->throwRange && enemies->cooldown[i] <= 0.0f) {
+                enemies->facing[i] = toPlayer;
+                SetState(enemies, i, ENEMY_THROW);
+            } else if ((behaviours & ENEMY_CHASES) && enemies->state[i] != ENEMY_CHASE) {
+                SetState(enemies, i, ENEMY_CHASE);
+            }
+            break;
+
+        case ENEMY_THROW:
+            if (enemies->timer[i] < desc->throwTime) break;
+            if (update->throwCount < ENEMY_MAX_THROWS) update->throws[update->throwCount++] = i;
+            enemies->cooldown[i] = desc->throwCooldown;
+            SetState(enemies, i, (seen && (behaviours & ENEMY_CHASES)) ? ENEMY_CHASE : ENEMY_PATROL);
+            break;
+
+        case ENEMY_HIDE:
+            if (enemies->timer[i] >= desc->hideTime && (!seen || fabsf(dx) > desc->hideRange))
+                SetState(enemies, i, ENEMY_PATROL);
+            break;
+    }
+}
+
+// Walk along the platform, never past its ends or the enemy's range
+static void Walk(Enemies *enemies, int i, const EnemyDesc *desc, const EnemyUpdate *update, float targetX, float dt)
+{
+    Rectangle platform = update->platforms[enemies->platform[i]];
+    float home = enemies->homeX[i];
+    float lo = fmaxf(platform.x, home - desc->range);
+    float hi = fminf(platform.x + platform.width - desc->width, home + desc->range);
+    if (lo > hi) {
+        // Stepped off past its range to drop onto this platform: keep to it
+        lo = platform.x;
+        hi = fmaxf(platform.x + platform.width - desc->width, lo);
+    }
+
+    float x = enemies->x[i];
+    if (enemies->state[i] == ENEMY_PATROL) {
+        x += enemies->facing[i]*desc->patrolSpeed*dt;
+        if (x <= lo) { x = lo; enemies->facing[i] = 1; }
+        else if (x >= hi) { x = hi; enemies->facing[i] = -1; }
+    } else if (enemies->state[i] == ENEMY_CHASE) {
+        float step = desc->chaseSpeed*dt;
+        float dx = targetX - x;
+        if (dx != 0.0f) enemies->facing[i] = (dx < 0) ? -1 : 1;
+        x += fminf(fmaxf(dx, -step), step);
+        x = fminf(fmaxf(x, lo), hi);
+    }
+    enemies->x[i] = x;
+}
+
+// Chase a player on another platform along the route from the span under
+// the enemy: on to the next span, or to the takeoff of a jump or a drop.
+// Moves targetX there, and returns false once the enemy moved itself (it
+// took off, or steps off the end) so it does not walk this update. With no
+// route within the enemy's range it chases along its own platform.
+static bool Navigate(Enemies *enemies, int i, const EnemyDesc *desc, EnemyUpdate *update, float dt, float *targetX)
+{
+    NavGraph *nav = update->nav;
+    int platform = enemies->platform[i];
+    if (nav == NULL || update->playerSpan < 0 || nav->spans[update->playerSpan].platform == platform) return true;
+
+    float centerX = enemies->x[i] + desc->width/2;
+    int e = FindNavRoute(nav, GetNavSpan(nav, platform, centerX), update->playerSpan);
+    if (e < 0) return true;
+
+    const NavEdge *edge = &nav->edges[e];
+    const NavSpan *next = &nav->spans[edge->to];
+    const float nextX = (next->x0 + next->x1)/2;
+    const float home = enemies->homeX[i];
+    if (fabsf(edge->takeoffX - desc->width/2 - home) > desc->range ||
+        next->x1 < home - desc->range || next->x0 > home + desc->range + desc->width) return true;
+
+    if (edge->type == NAV_WALK) {
+        *targetX = nextX - desc->width/2;
+        return true;
+    }
+    if (fabsf(centerX - edge->takeoffX) > desc->width/2 + ENEMY_TAKEOFF_SLACK) {
+        *targetX = edge->takeoffX - desc->width/2;
+        return true;
+    }
+
+    int dir = (nextX < centerX) ? -1 : 1;
+    enemies->facing[i] = dir;
+    if (edge->type == NAV_FALL) {
+        // Step on past the end until nothing is left on the platform
+        Rectangle top = update->platforms[platform];
+        enemies->x[i] += dir*desc->chaseSpeed*dt;
+        if (enemies->x[i] < top.x + top.width && enemies->x[i] + desc->width > top.x) return false;
+        enemies->vy[i] = 0.0f;
+    } else {
+        enemies->vy[i] = nav->jumpForce;
+    }
+
+    enemies->vx[i] = dir*nav->airSpeed;
+    enemies->platform[i] = -1;
+    enemies->navTarget[i] = edge->to;
+    SetState(enemies, i, ENEMY_FALL);
+    return false;
+}
+
+void UpdateEnemies(Enemies *enemies, int begin, int end, int interval, int phase, EnemyUpdate *update)
+{
+    const float dt = update->dt*interval;
+    const Rectangle player = update->player;
+    const float playerX = player.x + player.width/2, playerY = player.y + player.height/2;
+
+    // First index in range with (i + phase) a multiple of interval
+    int start = begin + (interval - (begin + phase%interval)%interval)%interval;
+
+    for (int i = start; i < end; i += interval) {
+        const EnemyDesc *desc = &enemyDescs[enemies->kind[i]];
+        enemies->prevX[i] = enemies->x[i];
+        enemies->prevY[i] = enemies->y[i];
+        enemies->timer[i] += dt;
+        if (enemies->cooldown[i] > 0.0f) enemies->cooldown[i] -= dt;
+
+        if (enemies->platform[i] < 0) {
+            Fall(enemies, i, desc, update, dt);
+        } else {
+            float dx = playerX - (enemies->x[i] + desc->width/2);
+            float dy = playerY - (enemies->y[i] + desc->height/2);
+            bool seen = fabsf(dx) <= desc->sightRange && fabsf(dy) <= desc->sightHeight;
+            Think(enemies, i, desc, dx, seen, update);
+
+            float targetX = playerX - desc->width/2;
+            bool walks = enemies->state[i] != ENEMY_CHASE || !(desc->behaviours & ENEMY_NAVIGATES) ||
+                         Navigate(enemies, i, desc, update, dt, &targetX);
+            if (walks) Walk(enemies, i, desc, update, targetX, dt);
+        }
+
+        // Contact hurts, except from inside the box
+        Rectangle body = { enemies->x[i], enemies->y[i], desc->width, desc->height };
+        if (update->hit < 0 && enemies->state[i] != ENEMY_HIDE && OverlapRects(player, body)) update->hit = i;
+    }
+}
+
+void BlastEnemies(Enemies *enemies, int begin, int end, Vector2 center, float radius, Vector2 toss)
+{
+    for (int i = begin; i < end; i++) {
+        const EnemyDesc *desc = &enemyDescs[enemies->kind[i]];
+        float dx = enemies->x[i] + desc->width/2 - center.x;
+        float dy = enemies->y[i] + desc->height/2 - center.y;
+        if (dx*dx + dy*dy > radius*radius) continue;
+
+        enemies->vx[i] = (dx < 0) ? -toss.x : toss.x;
+        enemies->vy[i] = -toss.y;
+        enemies->platform[i] = -1;
+        enemies->navTarget[i] = -1;
+        SetState(enemies, i, ENEMY_FALL);
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef ENEMIES_H
+#define ENEMIES_H
+
+#include "raylib.h"
+#include "collision.h"
+#include "level.h"
+#include "memory.h"
+#include "navigation.h"
+#include "projectiles.h"
+
+// Pig enemies. Every kind shares one state machine; what a kind does in it
+// (speeds, ranges, which behaviours it has) comes from its EnemyDesc, so a
+// new kind is one table row. Stored as struct-of-arrays like the other
+// entities, in level order (sorted by spawn x).
+#define ENEMY_CHASES (1 << 0)       // runs at the player it sees
+#define ENEMY_THROWS (1 << 1)       // stops to throw at the player in range
+#define ENEMY_HIDES  (1 << 2)       // ducks into its box when the player comes close
+#define ENEMY_NAVIGATES (1 << 3)    // jumps and drops between platforms to reach the player
+
+typedef enum {
+    ENEMY_PATROL,           // walk back and forth around home
+    ENEMY_CHASE,
+    ENEMY_THROW,            // wind-up, then release
+    ENEMY_HIDE,             // harmless until the player leaves
+    ENEMY_FALL,             // not standing on a platform
+    ENEMY_STATE_COUNT
+} EnemyState;
+
+typedef struct {
+    float width;            // hitbox
+    float height;
+    float patrolSpeed;      // px/s
+    float chaseSpeed;
+    float range;            // how far from its spawn x an enemy may go, see AreEnemyRangesValid
+    float sightRange;       // notices a player this far away horizontally
+    float sightHeight;      // and this far above or below, further for kinds that can get there
+    float throwRange;
+    float throwTime;        // seconds from wind-up to release
+    float throwCooldown;
+    float hideRange;
+    float hideTime;         // seconds in the box at least
+    unsigned int behaviours;
+    int projectile;         // ProjectileKind thrown by ENEMY_THROWS kinds
+} EnemyDesc;
+
+extern const EnemyDesc enemyDescs[ENEMY_KIND_COUNT];
+
+typedef struct {
+    float *x;               // hitbox top-left
+    float *y;
+    float *prevX;           // position at the start of the last update
+    float *prevY;
+    float *vx;              // drift while in the air
+    float *vy;
+    float *homeX;           // spawn x, the center of the patrol
+    float *timer;           // seconds in the current state
+    float *cooldown;        // seconds until the next throw
+    int *kind;              // EnemyKind
+    int *state;             // EnemyState
+    int *facing;            // -1 left, 1 right
+    int *platform;          // platform stood on, -1 while falling
+    int *navTarget;         // span a jump or drop is headed for, -1 for none
+    int count;
+} Enemies;
+
+// What the enemies see of the world for one update, and what they did
+#define ENEMY_MAX_THROWS 16
+
+typedef struct {
+    const Rectangle *platforms;     // one-way, only their tops stop an enemy
+    SpatialGrid *platformGrid;
+    float worldHeight;              // enemies that fall below it stop
+    float gravity;
+    Rectangle player;
+    float dt;
+    NavGraph *nav;                  // routes for ENEMY_NAVIGATES kinds
+    int playerSpan;                 // span the player last stood on, -1 for none
+
+    int hit;                        // first enemy touching the player, -1 for none
+    int throwCount;                 // enemies that released a throw
+    int throws[ENEMY_MAX_THROWS];
+} EnemyUpdate;
+
+// Blasts and the simulation windows find enemies through the level's chunk
+// table, by spawn x, so an enemy must stay within a chunk of its spawn.
+// Air drift stops at the ends of its range, but stepping off a platform end
+// to drop takes its hitbox (top-left x) up to a body width past them.
+#define ENEMY_MAX_OVERSTEP 2    // body widths past the range a hitbox can reach
+bool AreEnemyRangesValid(void);
+
+bool AllocEnemies(Enemies *enemies, Arena *arena, int count);
+
+// Put every enemy back at its spawn point, falling onto the platform below
+void ResetEnemies(Enemies *enemies, const LevelEnemy *spawns);
+
+// Advance the enemies in [begin, end) whose index plus phase is a multiple
+// of interval, each by interval*dt. Enemies further from the player update
+// less often with a larger step (level of detail); interval 1 updates them
+// all. Not thread-safe: falling enemies query the platform grid, and
+// navigating ones share the route cache.
+void UpdateEnemies(Enemies *enemies, int begin, int end, int interval, int phase, EnemyUpdate *update);
+
+// Knock the enemies in [begin, end) within radius of a blast off their feet,
+// away from it at toss.x and up at toss.y (px/s)
+void BlastEnemies(Enemies *enemies, int begin, int end, Vector2 center, float radius, Vector2 toss);
+
+#endif
@@ -0,0 +1,150 @@
+#include "entities.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// Branch-free select: mask ? a : b
+#if defined(__SSE2__)
+static inline __m128 Select4(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+bool AllocSpikeHeads(SpikeHeads *spikes, Arena *arena, int count)
+{
+    *spikes = (SpikeHeads){ 0 };
+    float *block = ArenaAlloc(arena, 6*(count > 0 ? count : 1)*sizeof(float));
+    if (block == NULL) return false;
+
+    spikes->x = block;
+    spikes->y = spikes->x + count;
+    spikes->prevY = spikes->y + count;
+    spikes->vy = spikes->prevY + count;
+    spikes->minY = spikes->vy + count;
+    spikes->maxY = spikes->minY + count;
+    spikes->count = count;
+    return true;
+}
+
+bool AllocDiamonds(Diamonds *diamonds, Arena *arena, int count)
+{
+    *diamonds = (Diamonds){ 0 };
+
+    // float and int columns are both 4 bytes wide
+    float *block = ArenaAlloc(arena, 5*(count > 0 ? count : 1)*sizeof(float));
+    if (block == NULL) return false;
+
+    diamonds->x = block;
+    diamonds->y = diamonds->x + count;
+    diamonds->active = (int *)(diamonds->y + count);
+    diamonds->frame = diamonds->active + count;
+    diamonds->frameTimer = (float *)(diamonds->frame + count);
+    diamonds->count = count;
+    return true;
+}
+
+int UpdateSpikeHeads(SpikeHeads *spikes, int begin, int end, float dt, float speedDown, float speedUp, Rectangle player)
+{
+    // A spike at (x, y) overlaps the player when x and y fall inside these open ranges
+    const float xLo = player.x - spikes->width, xHi = player.x + player.width;
+    const float yLo = player.y - spikes->height, yHi = player.y + player.height;
+
+    int hit = -1;
+    int i = begin;
+
+#if defined(__SSE2__)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vdown = _mm_set1_ps(speedDown);
+    const __m128 vup = _mm_set1_ps(-speedUp);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vxLo = _mm_set1_ps(xLo), vxHi = _mm_set1_ps(xHi);
+    const __m128 vyLo = _mm_set1_ps(yLo), vyHi = _mm_set1_ps(yHi);
+
+    for (; i + 4 <= end; i += 4) {
+        __m128 y = _mm_loadu_ps(&spikes->y[i]);
+        __m128 vy = _mm_loadu_ps(&spikes->vy[i]);
+        _mm_storeu_ps(&spikes->prevY[i], y);
+
+        y = _mm_add_ps(y, _mm_mul_ps(vy, vdt));
+
+        // Turn around at the ends of the patrol
+        __m128 down = _mm_cmpgt_ps(vy, zero);
+        __m128 atBottom = _mm_and_ps(down, _mm_cmpge_ps(y, _mm_loadu_ps(&spikes->maxY[i])));
+        __m128 atTop = _mm_andnot_ps(down, _mm_cmple_ps(y, _mm_loadu_ps(&spikes->minY[i])));
+        vy = Select4(atBottom, vup, vy);
+        vy = Select4(atTop, vdown, vy);
+
+        _mm_storeu_ps(&spikes->y[i], y);
+        _mm_storeu_ps(&spikes->vy[i], vy);
+
+        __m128 x = _mm_loadu_ps(&spikes->x[i]);
+        __m128 overlap = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(x, vxLo), _mm_cmplt_ps(x, vxHi)),
+                                    _mm_and_ps(_mm_cmpgt_ps(y, vyLo), _mm_cmplt_ps(y, vyHi)));
+        int mask = _mm_movemask_ps(overlap);
+        if (mask && hit < 0) {
+            int k = 0;
+            while (!(mask & (1 << k))) k++;
+            hit = i + k;
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        float y = spikes->y[i];
+        float vy = spikes->vy[i];
+        spikes->prevY[i] = y;
+
+        y += vy*dt;
+        if (vy > 0 && y >= spikes->maxY[i]) vy = -speedUp;
+        else if (vy <= 0 && y <= spikes->minY[i]) vy = speedDown;
+
+        spikes->y[i] = y;
+        spikes->vy[i] = vy;
+
+        float x = spikes->x[i];
+        if (hit < 0 && x > xLo && x < xHi && y > yLo && y < yHi) hit = i;
+    }
+
+    return hit;
+}
+
+void UpdateDiamondAnimation(Diamonds *diamonds, int begin, int end, float dt, float frameSpeed, int frameCount)
+{
+    int i = begin;
+
+#if defined(__SSE2__)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vspeed = _mm_set1_ps(frameSpeed);
+    const __m128i lastFrame = _mm_set1_epi32(frameCount - 1);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= end; i += 4) {
+        __m128i active = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)&diamonds->active[i]), zero);
+        __m128 timer = _mm_loadu_ps(&diamonds->frameTimer[i]);
+        __m128i frame = _mm_loadu_si128((const __m128i *)&diamonds->frame[i]);
+
+        timer = _mm_add_ps(timer, _mm_and_ps(_mm_castsi128_ps(active), vdt));
+
+        // Lanes whose timer ran out reset it and step one frame (mask lanes are -1)
+        __m128 advance = _mm_and_ps(_mm_castsi128_ps(active), _mm_cmpge_ps(timer, vspeed));
+        timer = _mm_andnot_ps(advance, timer);
+        frame = _mm_sub_epi32(frame, _mm_castps_si128(advance));
+        frame = _mm_andnot_si128(_mm_cmpgt_epi32(frame, lastFrame), frame);
+
+        _mm_storeu_ps(&diamonds->frameTimer[i], timer);
+        _mm_storeu_si128((__m128i *)&diamonds->frame[i], frame);
+    }
+#endif
+
+    for (; i < end; i++) {
+        if (!diamonds->active[i]) continue;
+        diamonds->frameTimer[i] += dt;
+        if (diamonds->frameTimer[i] >= frameSpeed) {
+            diamonds->frameTimer[i] = 0;
+            diamonds->frame[i]++;
+            if (diamonds->frame[i] >= frameCount) diamonds->frame[i] = 0;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include "raylib.h"
+#include "memory.h"
+
+// Entities are stored as struct-of-arrays so the per-tick kernels can
+// stream each column and process four entities per SSE2 instruction.
+// All columns of a set share one block of the level arena.
+
+// Vertically oscillating hazards: vy > 0 while going down, < 0 going up
+typedef struct {
+    float *x;
+    float *y;
+    float *prevY;       // y at the start of the last tick
+    float *vy;
+    float *minY;        // top of the patrol
+    float *maxY;        // bottom of the patrol
+    float width;
+    float height;
+    int count;
+} SpikeHeads;
+
+// Animated collectibles, active[i] is 1 until picked up
+typedef struct {
+    float *x;
+    float *y;
+    int *active;
+    int *frame;
+    float *frameTimer;
+    float width;
+    float height;
+    int count;
+} Diamonds;
+
+bool AllocSpikeHeads(SpikeHeads *spikes, Arena *arena, int count);
+bool AllocDiamonds(Diamonds *diamonds, Arena *arena, int count);
+
+// The kernels below process entities [begin, end) so the job system can
+// split a set into ranges that run on different threads.
+
+// Move spike heads one tick, turning around at the ends of their patrol,
+// and test them against the player in the same pass.
+// Returns the index of the first spike head touching the player, or -1.
+int UpdateSpikeHeads(SpikeHeads *spikes, int begin, int end, float dt, float speedDown, float speedUp, Rectangle player);
+
+// Advance the animation timers of the active diamonds
+void UpdateDiamondAnimation(Diamonds *diamonds, int begin, int end, float dt, float frameSpeed, int frameCount);
+
+#endif
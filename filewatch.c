@@ -0,0 +1,120 @@
+#if defined(__linux__)
+    #define _GNU_SOURCE
+    #include <sys/inotify.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
+#include "filewatch.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+static long GetModTime(const char *path)
+{
+    struct stat st;
+    return (stat(path, &st) == 0) ? (long)st.st_mtime : 0;
+}
+
+// Split a path into its directory ("." when none) and file name
+static const char *SplitPath(const char *path, char *dir, int dirSize)
+{
+    const char *slash = strrchr(path, '/');
+    if (slash == NULL) {
+        strncpy(dir, ".", dirSize);
+        return path;
+    }
+    int length = (int)(slash - path);
+    if (length >= dirSize) length = dirSize - 1;
+    memcpy(dir, path, length);
+    dir[length] = '\0';
+    return slash + 1;
+}
+
+bool InitFileWatcher(FileWatcher *watcher, const char *const *paths, int count)
+{
+    memset(watcher, 0, sizeof(*watcher));
+    watcher->fd = -1;
+    if (count > MAX_WATCHED_FILES) count = MAX_WATCHED_FILES;
+
+    for (int i = 0; i < count; i++) {
+        watcher->paths[i] = paths[i];
+        watcher->modTimes[i] = GetModTime(paths[i]);
+    }
+    watcher->count = count;
+
+#if defined(__linux__)
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->fd < 0) return true;   // fall back to polling
+
+    for (int i = 0; i < count; i++) {
+        char dir[256];
+        SplitPath(paths[i], dir, sizeof(dir));
+
+        int d = 0;
+        while (d < watcher->dirCount && strcmp(watcher->dirs[d], dir) != 0) d++;
+        if (d < watcher->dirCount || d == MAX_WATCHED_DIRS) continue;
+
+        int wd = inotify_add_watch(watcher->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0) continue;
+        strcpy(watcher->dirs[d], dir);
+        watcher->dirWatches[d] = wd;
+        watcher->dirCount++;
+    }
+#endif
+    return true;
+}
+
+void CloseFileWatcher(FileWatcher *watcher)
+{
+#if defined(__linux__)
+    if (watcher->fd >= 0) close(watcher->fd);
+#endif
+    watcher->fd = -1;
+    watcher->count = 0;
+}
+
+int PollFileWatcher(FileWatcher *watcher, bool *changed)
+{
+    int changedCount = 0;
+    for (int i = 0; i < watcher->count; i++) changed[i] = false;
+
+#if defined(__linux__)
+    if (watcher->fd >= 0) {
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length;
+
+        while ((length = read(watcher->fd, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + length;) {
+                const struct inotify_event *event = (const struct inotify_event *)p;
+                p += sizeof(struct inotify_event) + event->len;
+                if (event->len == 0) continue;
+
+                for (int i = 0; i < watcher->count; i++) {
+                    char dir[256];
+                    const char *name = SplitPath(watcher->paths[i], dir, sizeof(dir));
+                    if (changed[i] || strcmp(name, event->name) != 0) continue;
+
+                    for (int d = 0; d < watcher->dirCount; d++) {
+                        if (watcher->dirWatches[d] == event->wd && strcmp(watcher->dirs[d], dir) == 0) {
+                            changed[i] = true;
+                            changedCount++;
+                        }
+                    }
+                }
+            }
+        }
+        return changedCount;
+    }
+#endif
+
+    for (int i = 0; i < watcher->count; i++) {
+        long modTime = GetModTime(watcher->paths[i]);
+        if (modTime != watcher->modTimes[i]) {
+            watcher->modTimes[i] = modTime;
+            changed[i] = true;
+            changedCount++;
+        }
+    }
+    return changedCount;
+}
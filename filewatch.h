@@ -0,0 +1,31 @@
+#ifndef FILEWATCH_H
+#define FILEWATCH_H
+
+#include <stdbool.h>
+
+// Reports which of a fixed list of files changed on disk. Uses inotify on
+// Linux (watching the parent directories, so editors that save by rename
+// are caught) and polls modification times elsewhere. Kept apart from
+// raylib.h like mapfile.c.
+#define MAX_WATCHED_FILES 64
+#define MAX_WATCHED_DIRS 16
+
+typedef struct {
+    const char *paths[MAX_WATCHED_FILES];
+    int count;
+    long modTimes[MAX_WATCHED_FILES];   // polling fallback
+    int fd;                             // inotify instance, -1 when polling
+    int dirWatches[MAX_WATCHED_DIRS];
+    char dirs[MAX_WATCHED_DIRS][256];
+    int dirCount;
+} FileWatcher;
+
+// Paths must stay valid while the watcher is in use
+bool InitFileWatcher(FileWatcher *watcher, const char *const *paths, int count);
+void CloseFileWatcher(FileWatcher *watcher);
+
+// Non-blocking: set changed[i] for every path modified since the last poll.
+// Returns the number of changed paths.
+int PollFileWatcher(FileWatcher *watcher, bool *changed);
+
+#endif
@@ -0,0 +1,568 @@
+#include "game.h"
+#include "profile.h"
+#include "jobs.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Physics in per-second units (the old per-frame values at 60 fps in comments)
+#define GRAVITY 1800.0f             // 0.5 px/frame^2
+#define JUMP_FORCE -720.0f          // -12 px/frame
+#define MOVE_SPEED 300.0f           // 5 px/frame
+#define KNOCKBACK_VELOCITY -360.0f  // -6 px/frame
+#define KNOCKBACK_DISTANCE 24.0f
+#define ENEMY_AIR_SPEED 180.0f      // enemies drift this fast while jumping or dropping
+#define BLAST_TOSS_X 240.0f         // enemies caught in a blast fly off this fast
+#define BLAST_TOSS_Y 540.0f
+
+#define FRAME_SPEED 0.15f
+#define DIAMOND_FRAME_SPEED 0.15f
+#define DIAMOND_SIZE 25
+
+#define SPIKEHEAD_WIDTH 78
+#define SPIKEHEAD_HEIGHT 78         // enemy/idle.png scaled x1.5
+#define SPIKE_AMPLITUDE 200.0f
+#define SPIKE_SPEED_DOWN 360.0f     // 6 px/frame
+#define SPIKE_SPEED_UP 120.0f       // 2 px/frame
+
+#define COLLISION_CELL_SIZE 128.0f
+#define MAX_NEARBY 256
+
+// Entities per job when a set is split across the worker threads
+#define SPIKEHEAD_JOB_GRAIN 1024
+#define DIAMOND_JOB_GRAIN 2048
+
+// Jobs cover the active range, so job indices start at first
+typedef struct {
+    SpikeHeads *spikes;
+    int first;
+    Rectangle player;
+    int hit;            // lowest index touching the player, -1 for none
+} SpikeHeadJob;
+
+typedef struct {
+    Diamonds *diamonds;
+    int first;
+} DiamondJob;
+
+static void RunSpikeHeadJob(void *data, int begin, int end)
+{
+    SpikeHeadJob *job = data;
+    int hit = UpdateSpikeHeads(job->spikes, job->first + begin, job->first + end, TICK_DT,
+                               SPIKE_SPEED_DOWN, SPIKE_SPEED_UP, job->player);
+    if (hit < 0) return;
+
+    // Keep the lowest index so the result matches a single pass
+    int current = __atomic_load_n(&job->hit, __ATOMIC_RELAXED);
+    while ((current < 0 || hit < current) &&
+           !__atomic_compare_exchange_n(&job->hit, &current, hit, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+static void RunDiamondJob(void *data, int begin, int end)
+{
+    DiamondJob *job = data;
+    UpdateDiamondAnimation(job->diamonds, job->first + begin, job->first + end, TICK_DT, DIAMOND_FRAME_SPEED, DIAMOND_FRAME_COUNT);
+}
+
+// Chunks [lo, hi] within radius of a center chunk, clamped to the level
+static void GetChunksAround(const Level *level, int center, int radius, int *lo, int *hi)
+{
+    *lo = (center - radius < 0) ? 0 : center - radius;
+    *hi = (center + radius >= level->header->chunkCount) ? level->header->chunkCount - 1 : center + radius;
+}
+
+// Move the active window when the player enters another chunk, and start
+// paging in the chunk that will activate next in the direction of travel
+static void UpdateActiveChunks(Game *game)
+{
+    const Level *level = game->level;
+    int chunk = GetLevelChunk(level, game->player.x + game->player.width/2);
+    if (chunk == game->activeChunk) return;
+
+    int lo, hi;
+    GetChunksAround(level, chunk, ACTIVE_CHUNK_RADIUS, &lo, &hi);
+    game->spikeFirst = level->chunks[lo].spikeHeadFirst;
+    game->spikeEnd = level->chunks[hi + 1].spikeHeadFirst;
+    game->diamondFirst = level->chunks[lo].diamondFirst;
+    game->diamondEnd = level->chunks[hi + 1].diamondFirst;
+    game->enemyFirst = level->chunks[lo].enemyFirst;
+    game->enemyEnd = level->chunks[hi + 1].enemyFirst;
+    game->cannonFirst = level->chunks[lo].cannonFirst;
+    game->cannonEnd = level->chunks[hi + 1].cannonFirst;
+
+    int lodLo, lodHi;
+    GetChunksAround(level, chunk, ENEMY_LOD_RADIUS, &lodLo, &lodHi);
+    game->enemyLodFirst = level->chunks[lodLo].enemyFirst;
+    game->enemyLodEnd = level->chunks[lodHi + 1].enemyFirst;
+
+    if (game->activeChunk >= 0) {
+        int ahead = (chunk > game->activeChunk) ? hi + 1 : lo - 1;
+        PrefetchLevelChunk(level, ahead);
+    }
+    game->activeChunk = chunk;
+}
+
+static void PushGameEvent(Game *game, GameEventType type, Vector2 position)
+{
+    game->events[game->eventCount%GAME_EVENT_CAPACITY] = (GameEvent){ type, position };
+    game->eventCount++;
+}
+
+// Lose a life, get knocked back and stunned for PLAYER_HIT_DURATION
+static void HitPlayer(Game *game)
+{
+    Rectangle *player = &game->player;
+    game->playerHit = true;
+    game->hitTimer = 0.0f;
+    game->lives -= 1;
+    // Knockback & slight bounce
+    game->velocityY = KNOCKBACK_VELOCITY;
+    if (game->facingRight) player->x -= KNOCKBACK_DISTANCE; else player->x += KNOCKBACK_DISTANCE;
+    // Start camera shake
+    game->shakeTimer = SHAKE_DURATION;
+    PushGameEvent(game, GAME_EVENT_HIT, (Vector2){ player->x + player->width/2, player->y + player->height/2 });
+}
+
+// A bomb went off: hurt the player within reach and throw the enemies
+// around it. Enemies are stored in spawn order, and Fall and
+// AreEnemyRangesValid keep each within a chunk of its spawn, even once
+// thrown, so the chunk table finds every one that can be in reach.
+static void Blast(Game *game, Vector2 center, float radius)
+{
+    const Level *level = game->level;
+    const Rectangle *player = &game->player;
+    float nearX = fminf(fmaxf(center.x, player->x), player->x + player->width);
+    float nearY = fminf(fmaxf(center.y, player->y), player->y + player->height);
+    float dx = nearX - center.x, dy = nearY - center.y;
+    if (dx*dx + dy*dy <= radius*radius && !game->playerHit) HitPlayer(game);
+
+    int lo = GetLevelChunk(level, center.x - radius - LEVEL_CHUNK_WIDTH);
+    int hi = GetLevelChunk(level, center.x + radius + LEVEL_CHUNK_WIDTH);
+    BlastEnemies(&game->enemies, level->chunks[lo].enemyFirst, level->chunks[hi + 1].enemyFirst, center, radius,
+                 (Vector2){ BLAST_TOSS_X, BLAST_TOSS_Y });
+    PushGameEvent(game, GAME_EVENT_EXPLODE, center);
+}
+
+// Failed part way through InitGame: release what was allocated
+static bool FailInitGame(Game *game)
+{
+    FreeArena(&game->arena);
+    return false;
+}
+
+bool InitGame(Game *game, const Level *level)
+{
+    const LevelHeader *header = level->header;
+    *game = (Game){ 0 };
+    if (!AreEnemyRangesValid()) return false;
+    InitArena(&game->arena, ARENA_BLOCK_SIZE);
+
+    game->level = level;
+    game->worldWidth = header->worldWidth;
+    game->worldHeight = header->worldHeight;
+    game->groundY = header->groundY;
+
+    // Collision runs against the merged platforms, the level keeps the
+    // originals for drawing
+    Rectangle *platforms = ArenaAlloc(&game->arena, (header->platformCount + 1)*sizeof(Rectangle));
+    if (platforms == NULL) return FailInitGame(game);
+    game->platformCount = MergeOneWayPlatforms(level->platforms, header->platformCount, platforms);
+    game->platforms = platforms;
+
+    SpikeHeads *spikes = &game->spikeHeads;
+    if (!AllocSpikeHeads(spikes, &game->arena, header->spikeHeadCount)) return FailInitGame(game);
+    spikes->width = SPIKEHEAD_WIDTH;
+    spikes->height = SPIKEHEAD_HEIGHT;
+    for (int i = 0; i < spikes->count; i++) {
+        spikes->x[i] = level->spikeHeads[i].x;
+        spikes->y[i] = level->spikeHeads[i].y;
+        spikes->prevY[i] = level->spikeHeads[i].y;
+        spikes->vy[i] = SPIKE_SPEED_DOWN;
+        spikes->minY[i] = level->spikeHeads[i].minY;
+        spikes->maxY[i] = level->spikeHeads[i].minY + SPIKE_AMPLITUDE;
+    }
+
+    if (!AllocDiamonds(&game->diamonds, &game->arena, header->diamondCount)) return FailInitGame(game);
+    game->diamonds.width = DIAMOND_SIZE;
+    game->diamonds.height = DIAMOND_SIZE;
+
+    if (!AllocEnemies(&game->enemies, &game->arena, header->enemyCount)) return FailInitGame(game);
+    game->cannonTimers = ArenaAlloc(&game->arena, (header->cannonCount + 1)*sizeof(float));
+    if (game->cannonTimers == NULL) return FailInitGame(game);
+
+    // Snapshots only need room for the widest active window
+    for (int c = 0; c < header->chunkCount; c++) {
+        int lo, hi;
+        GetChunksAround(level, c, ACTIVE_CHUNK_RADIUS, &lo, &hi);
+        int spikes = level->chunks[hi + 1].spikeHeadFirst - level->chunks[lo].spikeHeadFirst;
+        int diamonds = level->chunks[hi + 1].diamondFirst - level->chunks[lo].diamondFirst;
+        int enemies = level->chunks[hi + 1].enemyFirst - level->chunks[lo].enemyFirst;
+        int cannons = level->chunks[hi + 1].cannonFirst - level->chunks[lo].cannonFirst;
+        if (spikes > game->maxActiveSpikes) game->maxActiveSpikes = spikes;
+        if (diamonds > game->maxActiveDiamonds) game->maxActiveDiamonds = diamonds;
+        if (enemies > game->maxActiveEnemies) game->maxActiveEnemies = enemies;
+        if (cannons > game->maxActiveCannons) game->maxActiveCannons = cannons;
+    }
+
+    if (!BuildSpatialGrid(&game->platformGrid, &game->arena, game->platforms, game->platformCount, COLLISION_CELL_SIZE) ||
+        !BuildNavGraph(&game->nav, &game->arena, game->platforms, game->platformCount, &game->platformGrid,
+                       GRAVITY, JUMP_FORCE, ENEMY_AIR_SPEED)) return FailInitGame(game);
+
+    Rectangle *diamondRects = malloc((header->diamondCount + 1)*sizeof(Rectangle));
+    if (diamondRects == NULL) return FailInitGame(game);
+    for (int i = 0; i < game->diamonds.count; i++)
+        diamondRects[i] = (Rectangle){ level->diamonds[i].x, level->diamonds[i].y, DIAMOND_SIZE, DIAMOND_SIZE };
+    bool built = BuildSpatialGrid(&game->diamondGrid, &game->arena, diamondRects, game->diamonds.count, COLLISION_CELL_SIZE);
+    free(diamondRects);
+    if (!built) return FailInitGame(game);
+
+    // Everything allocated from here on belongs to the current run. Later
+    // resets reuse the same arena space, so only this first one can fail.
+    game->runMark = GetArenaMark(&game->arena);
+    ResetGame(game);
+    if (game->projectiles.capacity == 0) return FailInitGame(game);
+    return true;
+}
+
+void UnloadGame(Game *game)
+{
+    FreeArena(&game->arena);
+}
+
+// Restart the run: player, lives, score, diamonds and enemies (spike heads keep moving).
+// Per-run allocations (pools of short-lived entities) go in one arena reset.
+void ResetGame(Game *game)
+{
+    ResetArena(&game->arena, game->runMark);
+    InitProjectiles(&game->projectiles, &game->arena);
+
+    game->tick = 0;
+    Vector2 spawn = game->level->header->spawn;
+    game->player = (Rectangle){ spawn.x + PLAYER_HITBOX_OFFSET_X, spawn.y + PLAYER_HITBOX_OFFSET_Y,
+                                PLAYER_HITBOX_WIDTH, PLAYER_HITBOX_HEIGHT };
+    game->prevPlayer = (Vector2){ game->player.x, game->player.y };
+    game->velocityY = 0;
+    game->onGround = false;
+    game->playerPlatform = -1;
+    game->facingRight = true;
+    game->moving = false;
+    game->state = PLAYER_IDLE;
+    game->frame = 0;
+    game->frameTimer = 0;
+    game->lives = PLAYER_LIVES;
+    game->playerHit = false;
+    game->hitTimer = 0;
+    game->score = 0;
+    game->activeChunk = -1;
+    UpdateActiveChunks(game);
+
+    Diamonds *diamonds = &game->diamonds;
+    for (int i = 0; i < diamonds->count; i++) {
+        diamonds->x[i] = game->level->diamonds[i].x;
+        diamonds->y[i] = game->level->diamonds[i].y;
+        diamonds->active[i] = 1;
+        diamonds->frame[i] = 0;
+        diamonds->frameTimer[i] = 0;
+    }
+
+    ResetEnemies(&game->enemies, game->level->enemies);
+
+    // Spread the first shots over each cannon's period, so a row of
+    // cannons does not fire in step
+    for (int i = 0; i < game->level->header->cannonCount; i++)
+        game->cannonTimers[i] = game->level->cannons[i].period*fmodf(i*0.618034f, 1.0f);
+
+    // Routes found are still right, but a replay must start with the same
+    // cache to spend the same search budget
+    ClearNavCache(&game->nav);
+}
+
+bool IsGameWon(const Game *game)
+{
+    return game->score == game->diamonds.count;
+}
+
+bool IsGameOver(const Game *game)
+{
+    return game->lives <= 0;
+}
+
+bool AllocGameSnapshot(GameSnapshot *snapshot, const Game *game)
+{
+    int spikeCount = game->maxActiveSpikes;
+    int diamondCount = game->maxActiveDiamonds;
+    int enemyCount = game->maxActiveEnemies;
+    int cannonCount = game->maxActiveCannons;
+    *snapshot = (GameSnapshot){ 0 };
+
+    // One block: spike y, prevY, diamond active, frame, enemy x, y, prevX,
+    // prevY, timer, state, facing, cannon timer (all 4 bytes wide), then
+    // room for a full projectile pool
+    int columns = 2*spikeCount + 2*diamondCount + 7*enemyCount + cannonCount;
+    float *block = calloc(columns + PROJECTILE_CAPACITY*sizeof(Projectile)/sizeof(float) + 1, sizeof(float));
+    if (block == NULL) return false;
+
+    snapshot->spikeY = block;
+    snapshot->spikePrevY = snapshot->spikeY + spikeCount;
+    snapshot->diamondActive = (int *)(snapshot->spikePrevY + spikeCount);
+    snapshot->diamondFrame = snapshot->diamondActive + diamondCount;
+    snapshot->enemyX = (float *)(snapshot->diamondFrame + diamondCount);
+    snapshot->enemyY = snapshot->enemyX + enemyCount;
+    snapshot->enemyPrevX = snapshot->enemyY + enemyCount;
+    snapshot->enemyPrevY = snapshot->enemyPrevX + enemyCount;
+    snapshot->enemyTimer = snapshot->enemyPrevY + enemyCount;
+    snapshot->enemyState = (int *)(snapshot->enemyTimer + enemyCount);
+    snapshot->enemyFacing = snapshot->enemyState + enemyCount;
+    snapshot->cannonTimer = (float *)(snapshot->enemyFacing + enemyCount);
+    snapshot->projectiles = (Projectile *)(snapshot->cannonTimer + cannonCount);
+    return true;
+}
+
+void FreeGameSnapshot(GameSnapshot *snapshot)
+{
+    free(snapshot->spikeY);
+    *snapshot = (GameSnapshot){ 0 };
+}
+
+void CaptureGameSnapshot(const Game *game, GameSnapshot *snapshot)
+{
+    snapshot->player = game->player;
+    snapshot->prevPlayer = game->prevPlayer;
+    snapshot->state = game->state;
+    snapshot->frame = game->frame;
+    snapshot->facingRight = game->facingRight;
+    snapshot->hitTimer = game->hitTimer;
+    snapshot->shakeTimer = game->shakeTimer;
+    snapshot->score = game->score;
+    snapshot->lives = game->lives;
+    snapshot->won = IsGameWon(game);
+    snapshot->over = IsGameOver(game);
+    memcpy(snapshot->events, game->events, sizeof(game->events));
+    snapshot->eventCount = game->eventCount;
+
+    snapshot->diamondTotal = game->diamonds.count;
+
+    int spikeFirst = game->spikeFirst, diamondFirst = game->diamondFirst;
+    snapshot->spikeFirst = spikeFirst;
+    snapshot->spikeHeadCount = game->spikeEnd - spikeFirst;
+    snapshot->diamondFirst = diamondFirst;
+    snapshot->diamondCount = game->diamondEnd - diamondFirst;
+
+    memcpy(snapshot->spikeY, game->spikeHeads.y + spikeFirst, snapshot->spikeHeadCount*sizeof(float));
+    memcpy(snapshot->spikePrevY, game->spikeHeads.prevY + spikeFirst, snapshot->spikeHeadCount*sizeof(float));
+    memcpy(snapshot->diamondActive, game->diamonds.active + diamondFirst, snapshot->diamondCount*sizeof(int));
+    memcpy(snapshot->diamondFrame, game->diamonds.frame + diamondFirst, snapshot->diamondCount*sizeof(int));
+
+    const Enemies *enemies = &game->enemies;
+    int enemyFirst = game->enemyFirst, enemyCount = game->enemyEnd - enemyFirst;
+    snapshot->enemyFirst = enemyFirst;
+    snapshot->enemyCount = enemyCount;
+    memcpy(snapshot->enemyX, enemies->x + enemyFirst, enemyCount*sizeof(float));
+    memcpy(snapshot->enemyY, enemies->y + enemyFirst, enemyCount*sizeof(float));
+    memcpy(snapshot->enemyPrevX, enemies->prevX + enemyFirst, enemyCount*sizeof(float));
+    memcpy(snapshot->enemyPrevY, enemies->prevY + enemyFirst, enemyCount*sizeof(float));
+    memcpy(snapshot->enemyTimer, enemies->timer + enemyFirst, enemyCount*sizeof(float));
+    memcpy(snapshot->enemyState, enemies->state + enemyFirst, enemyCount*sizeof(int));
+    memcpy(snapshot->enemyFacing, enemies->facing + enemyFirst, enemyCount*sizeof(int));
+
+    snapshot->cannonFirst = game->cannonFirst;
+    snapshot->cannonCount = game->cannonEnd - game->cannonFirst;
+    memcpy(snapshot->cannonTimer, game->cannonTimers + game->cannonFirst, snapshot->cannonCount*sizeof(float));
+
+    const Pool *projectiles = &game->projectiles;
+    snapshot->projectileCount = 0;
+    for (int i = 0; i < projectiles->highWater; i++) {
+        const Projectile *p = GetPoolItem(projectiles, i);
+        if (p != NULL) snapshot->projectiles[snapshot->projectileCount++] = *p;
+    }
+}
+
+void UpdateGame(Game *game, const GameInput *input)
+{
+    const float dt = TICK_DT;
+    Rectangle *player = &game->player;
+
+    if (input->restart && (IsGameWon(game) || IsGameOver(game))) {
+        ResetGame(game);
+        return;
+    }
+
+    PROFILE_BEGIN(PROFILE_TICK);
+    PROFILE_BEGIN(PROFILE_PLAYER);
+    game->tick++;
+
+    // Remember where the player was so the renderer can interpolate
+    game->prevPlayer = (Vector2){ player->x, player->y };
+
+    // Update hit timer if player is hit
+    if (game->playerHit) {
+        game->hitTimer += dt;
+        if (game->hitTimer >= PLAYER_HIT_DURATION) {
+            game->playerHit = false;
+            game->hitTimer = 0.0f;
+        }
+    }
+
+    // Movement (disabled during hit)
+    float dx = 0.0f;
+    game->moving = false;
+    if (!game->playerHit) {
+        if (input->right) { dx += MOVE_SPEED*dt; game->facingRight = true; game->moving = true; }
+        if (input->left) { dx -= MOVE_SPEED*dt; game->facingRight = false; game->moving = true; }
+    }
+
+    // World bounds
+    if (player->x + dx < 0) dx = -player->x;
+    if (player->x + dx + player->width > game->worldWidth) dx = game->worldWidth - player->width - player->x;
+
+    // Apply gravity
+    game->velocityY += GRAVITY*dt;
+    float dy = game->velocityY*dt;
+    bool wasOnGround = game->onGround;
+    game->onGround = false;
+
+    // Sweep the whole move against nearby platforms and keep the earliest
+    // landing. Platforms are one-way, so only their top face stops the player.
+    Rectangle swept = {
+        (dx < 0) ? player->x + dx : player->x, (dy < 0) ? player->y + dy : player->y,
+        player->width + fabsf(dx), player->height + fabsf(dy)
+    };
+    int nearby[MAX_NEARBY];
+    int nearbyCount = QuerySpatialGrid(&game->platformGrid, swept, nearby, MAX_NEARBY);
+
+    float landingTime = 1.0f;
+    int landing = -1;
+    for (int n = 0; n < nearbyCount; n++) {
+        float toi;
+        Vector2 normal;
+        if (SweepRects(*player, (Vector2){ dx, dy }, game->platforms[nearby[n]], &toi, &normal) &&
+            normal.y < 0 && toi <= landingTime) {
+            landingTime = toi;
+            landing = nearby[n];
+        }
+    }
+
+    player->x += dx;
+    if (landing >= 0) {
+        player->y = game->platforms[landing].y - player->height;
+        game->velocityY = 0;
+        game->onGround = true;
+        game->playerPlatform = landing;
+        if (!wasOnGround) PushGameEvent(game, GAME_EVENT_LAND, (Vector2){ player->x + player->width/2, player->y + player->height });
+    } else {
+        player->y += dy;
+    }
+
+    // Jump
+    if (!game->playerHit && game->onGround && input->jump) {
+        game->velocityY = JUMP_FORCE;
+        game->onGround = false;
+    }
+
+    UpdateActiveChunks(game);
+
+    PROFILE_END(PROFILE_PLAYER);
+    PROFILE_BEGIN(PROFILE_SPIKEHEADS);
+
+    // Spike Head movement and collision in one pass over the active set,
+    // split across the job system for crowded levels
+    JobCounter jobs;
+    SpikeHeadJob spikeJob = { &game->spikeHeads, game->spikeFirst, *player, -1 };
+    ParallelFor(&jobs, game->spikeEnd - game->spikeFirst, SPIKEHEAD_JOB_GRAIN, RunSpikeHeadJob, &spikeJob);
+    WaitJobs(&jobs);
+    int hitSpike = spikeJob.hit;
+
+    // Collision triggers hit (only if not already stunned)
+    if (hitSpike >= 0 && !game->playerHit) HitPlayer(game);
+
+    PROFILE_END(PROFILE_SPIKEHEADS);
+    PROFILE_BEGIN(PROFILE_ENEMIES);
+
+    // Enemies in the active chunks every tick, the ones further out at a
+    // reduced rate, a different share of them each tick
+    Enemies *enemies = &game->enemies;
+    EnemyUpdate enemyUpdate = {
+        .platforms = game->platforms, .platformGrid = &game->platformGrid, .worldHeight = game->worldHeight,
+        .gravity = GRAVITY, .player = *player, .dt = dt, .hit = -1, .nav = &game->nav,
+        .playerSpan = (game->playerPlatform >= 0) ? GetNavSpan(&game->nav, game->playerPlatform, player->x + player->width/2) : -1
+    };
+    BeginNavTick(&game->nav);
+    int phase = (int)(game->tick%ENEMY_LOD_INTERVAL);
+    UpdateEnemies(enemies, game->enemyFirst, game->enemyEnd, 1, 0, &enemyUpdate);
+    UpdateEnemies(enemies, game->enemyLodFirst, game->enemyFirst, ENEMY_LOD_INTERVAL, phase, &enemyUpdate);
+    UpdateEnemies(enemies, game->enemyEnd, game->enemyLodEnd, ENEMY_LOD_INTERVAL, phase, &enemyUpdate);
+
+    if (enemyUpdate.hit >= 0 && !game->playerHit) HitPlayer(game);
+
+    // Throws are lobbed from above the thrower's head at the player
+    Vector2 target = { player->x + player->width/2, player->y + player->height/2 };
+    for (int n = 0; n < enemyUpdate.throwCount; n++) {
+        int i = enemyUpdate.throws[n];
+        const EnemyDesc *desc = &enemyDescs[enemies->kind[i]];
+        Vector2 from = { enemies->x[i] + desc->width/2, enemies->y[i] };
+        float gravity = GRAVITY*projectileDescs[desc->projectile].gravity;
+        SpawnProjectile(&game->projectiles, desc->projectile, from, AimProjectile(from, target, gravity));
+        PushGameEvent(game, GAME_EVENT_THROW, from);
+    }
+
+    PROFILE_END(PROFILE_ENEMIES);
+    PROFILE_BEGIN(PROFILE_PROJECTILES);
+
+    FireCannons(game->level->cannons, game->cannonTimers, game->cannonFirst, game->cannonEnd, dt, &game->projectiles);
+
+    ProjectileUpdate projectileUpdate = {
+        .platforms = game->platforms, .platformGrid = &game->platformGrid, .worldWidth = game->worldWidth,
+        .worldHeight = game->worldHeight, .gravity = GRAVITY, .player = *player, .dt = dt
+    };
+    UpdateProjectiles(&game->projectiles, &projectileUpdate);
+
+    if (projectileUpdate.hit && !game->playerHit) HitPlayer(game);
+    for (int n = 0; n < projectileUpdate.impactCount; n++) {
+        const ProjectileImpact *impact = &projectileUpdate.impacts[n];
+        const ProjectileDesc *desc = &projectileDescs[impact->kind];
+        if (desc->blastRadius > 0.0f) Blast(game, impact->position, desc->blastRadius);
+        else PushGameEvent(game, (impact->kind == PROJECTILE_BOX) ? GAME_EVENT_BREAK : GAME_EVENT_IMPACT, impact->position);
+    }
+
+    PROFILE_END(PROFILE_PROJECTILES);
+
+    // Player animation state
+    if (game->playerHit) game->state = PLAYER_HIT;
+    else if (!game->onGround) game->state = (game->velocityY < 0) ? PLAYER_JUMP : PLAYER_FALL;
+    else if (game->moving) game->state = PLAYER_RUN;
+    else game->state = PLAYER_IDLE;
+
+    // Animation update (hit frames are derived from hitTimer when drawing)
+    if (game->state != PLAYER_HIT) {
+        game->frameTimer += dt;
+        if (game->frameTimer >= FRAME_SPEED) {
+            game->frameTimer = 0;
+            game->frame++;
+        }
+    }
+
+    // Diamond collisions
+    PROFILE_BEGIN(PROFILE_DIAMONDS);
+    Diamonds *diamonds = &game->diamonds;
+    nearbyCount = QuerySpatialGrid(&game->diamondGrid, *player, nearby, MAX_NEARBY);
+    for (int n = 0; n < nearbyCount; n++) {
+        int i = nearby[n];
+        Rectangle diamond = { diamonds->x[i], diamonds->y[i], diamonds->width, diamonds->height };
+        if (diamonds->active[i] && OverlapRects(*player, diamond)) {
+            game->score++;
+            diamonds->active[i] = 0;
+        }
+    }
+
+    DiamondJob diamondJob = { diamonds, game->diamondFirst };
+    ParallelFor(&jobs, game->diamondEnd - game->diamondFirst, DIAMOND_JOB_GRAIN, RunDiamondJob, &diamondJob);
+
+    // Camera shake countdown (the random offset itself is applied when drawing)
+    if (game->shakeTimer > 0.0f) game->shakeTimer -= dt;
+
+    WaitJobs(&jobs);
+    PROFILE_END(PROFILE_DIAMONDS);
+
+    PROFILE_END(PROFILE_TICK);
+}
@@ -0,0 +1,205 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "raylib.h"
+#include "collision.h"
+#include "entities.h"
+#include "enemies.h"
+#include "projectiles.h"
+#include "level.h"
+#include "memory.h"
+
+#define SCREEN_WIDTH 1000
+#define SCREEN_HEIGHT 700
+
+// Fixed simulation rate, independent from the render rate
+#define TICK_RATE 120
+#define TICK_DT (1.0f / TICK_RATE)
+
+// Player hitbox inside the 78x58 (x2) sprite frame
+#define PLAYER_HITBOX_OFFSET_X 30
+#define PLAYER_HITBOX_OFFSET_Y 40
+#define PLAYER_HITBOX_WIDTH 60
+#define PLAYER_HITBOX_HEIGHT 48
+#define PLAYER_LIVES 3
+
+#define PLAYER_HIT_DURATION 0.6f   // seconds of stun / animation
+#define SHAKE_DURATION 0.15f
+#define SHAKE_MAGNITUDE 6
+
+#define DIAMOND_FRAME_COUNT 10
+
+// Only entities within this many level chunks of the player are simulated
+// and published to the renderer; the rest stay frozen until it comes back.
+// Two chunks either side keep everything on screen active.
+#define ACTIVE_CHUNK_RADIUS 2
+
+// Enemies are simulated at three levels of detail: every tick in the active
+// chunks, every ENEMY_LOD_INTERVAL ticks (staggered, with a longer step) up
+// to ENEMY_LOD_RADIUS chunks away, and not at all beyond that
+#define ENEMY_LOD_RADIUS 4
+#define ENEMY_LOD_INTERVAL 8
+
+typedef enum {
+    PLAYER_IDLE,
+    PLAYER_RUN,
+    PLAYER_JUMP,
+    PLAYER_FALL,
+    PLAYER_HIT
+} PlayerState;
+
+// Things that happened during a tick, for effects on the render side. The
+// game keeps the last GAME_EVENT_CAPACITY in a ring; eventCount only grows,
+// so a reader that remembers the count it saw knows which ones are new.
+#define GAME_EVENT_CAPACITY 16
+
+typedef enum {
+    GAME_EVENT_LAND,        // the player touched down
+    GAME_EVENT_HIT,         // a spike head or an enemy hit the player
+    GAME_EVENT_THROW,       // an enemy let go of a box or bomb
+    GAME_EVENT_BREAK,       // a thrown box broke
+    GAME_EVENT_IMPACT,      // a cannon ball hit something
+    GAME_EVENT_EXPLODE      // a bomb went off
+} GameEventType;
+
+typedef struct {
+    GameEventType type;
+    Vector2 position;
+} GameEvent;
+
+// Input for one simulation tick. Edge-triggered keys stay latched
+// until a tick consumes them, so no press is lost between render frames.
+typedef struct {
+    bool left;
+    bool right;
+    bool jump;
+    bool restart;
+} GameInput;
+
+typedef struct {
+    unsigned int tick;          // ticks since the run started
+
+    // Player
+    Rectangle player;
+    Vector2 prevPlayer;         // position at the start of the last tick
+    float velocityY;
+    bool onGround;
+    int playerPlatform;         // platform last stood on, -1 until the first landing
+    bool facingRight;
+    bool moving;
+    PlayerState state;
+    int frame;
+    float frameTimer;
+    int lives;
+    bool playerHit;
+    float hitTimer;
+    float shakeTimer;
+    int score;
+
+    GameEvent events[GAME_EVENT_CAPACITY];
+    unsigned int eventCount;
+
+    // Level (entity tables are used in place from the mapped level file)
+    const Level *level;
+    Arena arena;                // everything owned by the level, freed in UnloadGame
+    ArenaMark runMark;          // start of the allocations reset on restart
+    float worldWidth;
+    float worldHeight;
+    float groundY;
+    const Rectangle *platforms;     // merged one-way platforms, for collision
+    int platformCount;
+
+    Diamonds diamonds;
+    SpikeHeads spikeHeads;
+    Enemies enemies;
+    float *cannonTimers;        // seconds since each cannon fired
+    Pool projectiles;           // Projectile items, rebuilt every run
+
+    // Streaming: the active chunks and their entity ranges [first, end)
+    int activeChunk;            // chunk under the player, -1 before the first tick
+    int spikeFirst;
+    int spikeEnd;
+    int diamondFirst;
+    int diamondEnd;
+    int enemyFirst;
+    int enemyEnd;
+    int enemyLodFirst;          // enemies within ENEMY_LOD_RADIUS chunks
+    int enemyLodEnd;
+    int cannonFirst;
+    int cannonEnd;
+    int maxActiveSpikes;        // largest active range anywhere in the level
+    int maxActiveDiamonds;
+    int maxActiveEnemies;
+    int maxActiveCannons;
+
+    // Broadphase and enemy navigation, built at level load
+    SpatialGrid platformGrid;
+    SpatialGrid diamondGrid;
+    NavGraph nav;
+} Game;
+
+// Immutable copy of everything the renderer needs from one tick, so drawing
+// can read it while the simulation already works on the next tick.
+// Static data (level geometry, entity x/diamond positions) is read from the
+// Level instead. Only the active entity ranges are copied: spikeY[i] is
+// spike head spikeFirst + i, and likewise for the diamonds and enemies.
+typedef struct {
+    double time;                // when this tick was due, on the GetProfileTime clock
+    long long tick;
+
+    Rectangle player;
+    Vector2 prevPlayer;
+    PlayerState state;
+    int frame;
+    bool facingRight;
+    float hitTimer;
+    float shakeTimer;
+    int score;
+    int lives;
+    bool won;
+    bool over;
+
+    GameEvent events[GAME_EVENT_CAPACITY];
+    unsigned int eventCount;
+
+    int diamondTotal;
+
+    int spikeFirst;
+    int spikeHeadCount;
+    float *spikeY;
+    float *spikePrevY;
+    int diamondFirst;
+    int diamondCount;
+    int *diamondActive;
+    int *diamondFrame;
+    int enemyFirst;
+    int enemyCount;
+    float *enemyX;
+    float *enemyY;
+    float *enemyPrevX;
+    float *enemyPrevY;
+    float *enemyTimer;
+    int *enemyState;
+    int *enemyFacing;
+    int cannonFirst;
+    int cannonCount;
+    float *cannonTimer;
+    int projectileCount;        // every live projectile, packed
+    Projectile *projectiles;
+} GameSnapshot;
+
+// Returns false when the level does not fit in memory, or the enemy table
+// lets enemies leave the chunks next to their spawn
+bool InitGame(Game *game, const Level *level);
+void ResetGame(Game *game);
+void UnloadGame(Game *game);
+void UpdateGame(Game *game, const GameInput *input);   // Advance one fixed tick
+
+bool IsGameWon(const Game *game);
+bool IsGameOver(const Game *game);
+
+bool AllocGameSnapshot(GameSnapshot *snapshot, const Game *game);
+void FreeGameSnapshot(GameSnapshot *snapshot);
+void CaptureGameSnapshot(const Game *game, GameSnapshot *snapshot);
+
+#endif
@@ -0,0 +1,215 @@
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #define _POSIX_C_SOURCE 200112L
+    #include <unistd.h>
+#endif
+
+#include "jobs.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+typedef struct {
+    JobFunc func;
+    void *data;
+    int begin;
+    int end;
+    JobCounter *counter;
+} Job;
+
+// front is where thieves take the oldest job, back where the owner works
+typedef struct {
+    pthread_mutex_t lock;
+    Job jobs[JOB_QUEUE_SIZE];
+    unsigned int front;
+    unsigned int back;
+} JobQueue;
+
+#define MAX_JOB_QUEUES (1 + MAX_JOB_WORKERS + MAX_JOB_CLIENTS)
+
+static struct {
+    pthread_t threads[MAX_JOB_WORKERS];
+    JobQueue queues[MAX_JOB_QUEUES];        // 0: main thread, then workers, then attached threads
+    int workerCount;
+    int queueCount;                         // queues thieves look at
+    bool clientAttached[MAX_JOB_CLIENTS];   // client queues in use
+    bool running;
+    int queuedJobs;                         // jobs sitting in any queue
+    pthread_mutex_t sleepLock;
+    pthread_cond_t wake;
+} jobSystem = { 0 };
+
+static __thread int threadIndex = 0;
+
+static int GetCoreCount(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (int)count : 1;
+#endif
+}
+
+static bool PushJob(JobQueue *queue, Job job)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool ok = (queue->back - queue->front < JOB_QUEUE_SIZE);
+    if (ok) queue->jobs[queue->back++ & (JOB_QUEUE_SIZE - 1)] = job;
+    pthread_mutex_unlock(&queue->lock);
+
+    if (ok) __atomic_add_fetch(&jobSystem.queuedJobs, 1, __ATOMIC_SEQ_CST);
+    return ok;
+}
+
+static bool PopJob(JobQueue *queue, Job *job, bool steal)
+{
+    pthread_mutex_lock(&queue->lock);
+    bool ok = (queue->back != queue->front);
+    if (ok) *job = steal ? queue->jobs[queue->front++ & (JOB_QUEUE_SIZE - 1)]
+                         : queue->jobs[--queue->back & (JOB_QUEUE_SIZE - 1)];
+    pthread_mutex_unlock(&queue->lock);
+
+    if (ok) __atomic_sub_fetch(&jobSystem.queuedJobs, 1, __ATOMIC_SEQ_CST);
+    return ok;
+}
+
+static void RunJob(Job *job)
+{
+    job->func(job->data, job->begin, job->end);
+    __atomic_sub_fetch(&job->counter->pending, 1, __ATOMIC_RELEASE);
+}
+
+// Run one job from the own queue, or (workers only) stolen from another thread
+static bool RunNextJob(bool steal)
+{
+    Job job;
+    int queueCount = __atomic_load_n(&jobSystem.queueCount, __ATOMIC_ACQUIRE);
+    if (PopJob(&jobSystem.queues[threadIndex], &job, false)) { RunJob(&job); return true; }
+    if (!steal) return false;
+
+    for (int i = 1; i < queueCount; i++) {
+        if (PopJob(&jobSystem.queues[(threadIndex + i) % queueCount], &job, true)) { RunJob(&job); return true; }
+    }
+    return false;
+}
+
+static void *WorkerMain(void *arg)
+{
+    threadIndex = (int)(long)arg;
+
+    while (__atomic_load_n(&jobSystem.running, __ATOMIC_ACQUIRE)) {
+        if (RunNextJob(true)) continue;
+
+        pthread_mutex_lock(&jobSystem.sleepLock);
+        while (jobSystem.running && __atomic_load_n(&jobSystem.queuedJobs, __ATOMIC_SEQ_CST) == 0)
+            pthread_cond_wait(&jobSystem.wake, &jobSystem.sleepLock);
+        pthread_mutex_unlock(&jobSystem.sleepLock);
+    }
+    return NULL;
+}
+
+int InitJobSystem(int workerCount)
+{
+    if (workerCount < 0) workerCount = GetCoreCount() - 1;
+    if (workerCount > MAX_JOB_WORKERS) workerCount = MAX_JOB_WORKERS;
+
+    pthread_mutex_init(&jobSystem.sleepLock, NULL);
+    pthread_cond_init(&jobSystem.wake, NULL);
+    for (int i = 0; i < MAX_JOB_QUEUES; i++) pthread_mutex_init(&jobSystem.queues[i].lock, NULL);
+
+    jobSystem.running = true;
+    jobSystem.workerCount = 0;
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&jobSystem.threads[i], NULL, WorkerMain, (void *)(long)(i + 1)) != 0) break;
+        jobSystem.workerCount++;
+    }
+    __atomic_store_n(&jobSystem.queueCount, jobSystem.workerCount + 1, __ATOMIC_RELEASE);
+    return jobSystem.workerCount;
+}
+
+void ShutdownJobSystem(void)
+{
+    pthread_mutex_lock(&jobSystem.sleepLock);
+    __atomic_store_n(&jobSystem.running, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&jobSystem.wake);
+    pthread_mutex_unlock(&jobSystem.sleepLock);
+
+    for (int i = 0; i < jobSystem.workerCount; i++) pthread_join(jobSystem.threads[i], NULL);
+    jobSystem.workerCount = 0;
+
+    jobSystem.queueCount = 0;
+    for (int i = 0; i < MAX_JOB_CLIENTS; i++) jobSystem.clientAttached[i] = false;
+    for (int i = 0; i < MAX_JOB_QUEUES; i++) pthread_mutex_destroy(&jobSystem.queues[i].lock);
+    pthread_cond_destroy(&jobSystem.wake);
+    pthread_mutex_destroy(&jobSystem.sleepLock);
+}
+
+int GetJobWorkerCount(void)
+{
+    return jobSystem.workerCount;
+}
+
+void AttachJobThread(void)
+{
+    if (jobSystem.workerCount == 0) return;     // everything runs inline
+    for (int i = 0; i < MAX_JOB_CLIENTS; i++) {
+        bool attached = false;
+        if (!__atomic_compare_exchange_n(&jobSystem.clientAttached[i], &attached, true, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            continue;
+
+        // Thieves only scan up to queueCount, which never shrinks
+        int index = jobSystem.workerCount + 1 + i;
+        int count = __atomic_load_n(&jobSystem.queueCount, __ATOMIC_ACQUIRE);
+        while (count <= index &&
+               !__atomic_compare_exchange_n(&jobSystem.queueCount, &count, index + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {}
+        threadIndex = index;
+        return;
+    }
+    threadIndex = 0;    // every client queue taken: share the main thread's
+}
+
+void DetachJobThread(void)
+{
+    int client = threadIndex - jobSystem.workerCount - 1;
+    if (client >= 0) __atomic_store_n(&jobSystem.clientAttached[client], false, __ATOMIC_RELEASE);
+    threadIndex = 0;
+}
+
+void ParallelFor(JobCounter *counter, int count, int grainSize, JobFunc func, void *data)
+{
+    counter->pending = 0;
+    if (count <= 0) return;
+    if (grainSize < 1) grainSize = 1;
+
+    if (jobSystem.workerCount == 0 || count <= grainSize) {
+        func(data, 0, count);
+        return;
+    }
+
+    __atomic_store_n(&counter->pending, (count + grainSize - 1)/grainSize, __ATOMIC_RELEASE);
+    for (int begin = 0; begin < count; begin += grainSize) {
+        Job job = { func, data, begin, (begin + grainSize < count) ? begin + grainSize : count, counter };
+        if (!PushJob(&jobSystem.queues[threadIndex], job)) RunJob(&job);    // queue full
+    }
+
+    pthread_mutex_lock(&jobSystem.sleepLock);
+    pthread_cond_broadcast(&jobSystem.wake);
+    pthread_mutex_unlock(&jobSystem.sleepLock);
+}
+
+bool IsJobDone(const JobCounter *counter)
+{
+    return __atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) <= 0;
+}
+
+void WaitJobs(JobCounter *counter)
+{
+    while (__atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) > 0) {
+        if (!RunNextJob(false)) sched_yield();
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdbool.h>
+
+// Small work-stealing job system. Every thread (the main thread included)
+// owns a queue: it pushes and pops jobs at the back, idle workers steal
+// from the front of other queues. Threads that wait on a counter run their
+// own queued jobs meanwhile instead of blocking, but never steal, so a
+// tick waiting on its entity jobs cannot get stuck behind a long asset job.
+#define MAX_JOB_WORKERS 31
+#define MAX_JOB_CLIENTS 8           // non-worker threads that submit jobs
+#define JOB_QUEUE_SIZE 1024         // jobs per thread queue, power of two
+
+// Process items [begin, end) of a parallel-for
+typedef void (*JobFunc)(void *data, int begin, int end);
+
+// Counts the unfinished jobs of one submission
+typedef struct {
+    int pending;
+} JobCounter;
+
+// Start workerCount threads (< 0: one per extra core, 0: run everything
+// on the calling thread). Returns the number of workers running.
+int InitJobSystem(int workerCount);
+void ShutdownJobSystem(void);
+int GetJobWorkerCount(void);
+
+// Give the calling thread its own queue. Every thread other than the one
+// that called InitJobSystem must attach before submitting jobs.
+void AttachJobThread(void);
+
+// Release the calling thread's queue for reuse, once all its jobs are done.
+// Call before an attached thread exits.
+void DetachJobThread(void);
+
+// Split [0, count) into ranges of at most grainSize items and queue them.
+// Runs inline when there are no workers or only one range.
+void ParallelFor(JobCounter *counter, int count, int grainSize, JobFunc func, void *data);
+
+// Help run jobs until every job of counter has finished
+void WaitJobs(JobCounter *counter);
+
+// Non-blocking check, for jobs polled once per frame
+bool IsJobDone(const JobCounter *counter);
+
+#endif
@@ -0,0 +1,144 @@
+#include "level.h"
+
+#include <math.h>
+
+// A table must lie inside the file and stay 4-byte aligned
+static bool IsTableValid(const MappedFile *file, int offset, int count, int elementSize)
+{
+    return (offset >= (int)sizeof(LevelHeader)) && (offset%4 == 0) && (count >= 0) &&
+           ((size_t)offset + (size_t)count*elementSize <= file->size);
+}
+
+// Chunk ranges must start at 0, never go backwards and end at the table sizes
+static bool AreChunksValid(const LevelHeader *header, const LevelChunk *chunks)
+{
+    int expected = (int)ceilf(header->worldWidth/LEVEL_CHUNK_WIDTH);
+    if (header->chunkCount != (expected > 0 ? expected : 1)) return false;
+
+    const LevelChunk *first = &chunks[0], *last = &chunks[header->chunkCount];
+    if (first->platformFirst < 0 || first->platformFirst > 1 || first->diamondFirst != 0 || first->spikeHeadFirst != 0 ||
+        first->enemyFirst != 0 || first->cannonFirst != 0 || last->platformFirst != header->platformCount ||
+        last->diamondFirst != header->diamondCount || last->spikeHeadFirst != header->spikeHeadCount ||
+        last->enemyFirst != header->enemyCount || last->cannonFirst != header->cannonCount) return false;
+
+    for (int c = 0; c < header->chunkCount; c++) {
+        if (chunks[c + 1].platformFirst < chunks[c].platformFirst || chunks[c + 1].diamondFirst < chunks[c].diamondFirst ||
+            chunks[c + 1].spikeHeadFirst < chunks[c].spikeHeadFirst || chunks[c + 1].enemyFirst < chunks[c].enemyFirst ||
+            chunks[c + 1].cannonFirst < chunks[c].cannonFirst) return false;
+    }
+    return true;
+}
+
+// Every enemy must be of a known kind
+static bool AreEnemiesValid(const LevelHeader *header, const LevelEnemy *enemies)
+{
+    for (int i = 0; i < header->enemyCount; i++) {
+        if (enemies[i].kind < 0 || enemies[i].kind >= ENEMY_KIND_COUNT) return false;
+    }
+    return true;
+}
+
+// Cannons face a side and fire at a positive period
+static bool AreCannonsValid(const LevelHeader *header, const LevelCannon *cannons)
+{
+    for (int i = 0; i < header->cannonCount; i++) {
+        if ((cannons[i].facing != -1 && cannons[i].facing != 1) || !(cannons[i].period > 0.0f)) return false;
+    }
+    return true;
+}
+
+// Tile layers cover the world in whole cells
+static bool AreTilesValid(const MappedFile *file, const LevelHeader *header)
+{
+    if (header->tileCols != (int)ceilf(header->worldWidth/TILE_SIZE) ||
+        header->tileRows != (int)ceilf(header->worldHeight/TILE_SIZE)) return false;
+
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) {
+        if (!IsTableValid(file, header->tileOffset[layer], header->tileCols*header->tileRows, 1)) return false;
+    }
+    return true;
+}
+
+bool LoadLevel(const char *path, Level *level)
+{
+    *level = (Level){ 0 };
+
+    if (!MapFile(path, &level->file)) return false;
+
+    const unsigned char *data = level->file.data;
+    const LevelHeader *header = (const LevelHeader *)data;
+
+    if (level->file.size < sizeof(LevelHeader) || header->magic != LEVEL_MAGIC || header->version != LEVEL_VERSION ||
+        !IsTableValid(&level->file, header->platformOffset, header->platformCount, sizeof(Rectangle)) ||
+        !IsTableValid(&level->file, header->diamondOffset, header->diamondCount, sizeof(Vector2)) ||
+        !IsTableValid(&level->file, header->spikeHeadOffset, header->spikeHeadCount, sizeof(LevelSpikeHead)) ||
+        !IsTableValid(&level->file, header->enemyOffset, header->enemyCount, sizeof(LevelEnemy)) ||
+        !IsTableValid(&level->file, header->cannonOffset, header->cannonCount, sizeof(LevelCannon)) ||
+        !IsTableValid(&level->file, header->chunkOffset, header->chunkCount + 1, sizeof(LevelChunk)) ||
+        !IsTableValid(&level->file, header->platformKindOffset, header->platformCount, 1) ||
+        !AreTilesValid(&level->file, header) ||
+        !AreEnemiesValid(header, (const LevelEnemy *)(data + header->enemyOffset)) ||
+        !AreCannonsValid(header, (const LevelCannon *)(data + header->cannonOffset)) ||
+        !AreChunksValid(header, (const LevelChunk *)(data + header->chunkOffset))) {
+        UnloadLevel(level);
+        return false;
+    }
+
+    level->header = header;
+    level->platforms = (const Rectangle *)(data + header->platformOffset);
+    level->diamonds = (const Vector2 *)(data + header->diamondOffset);
+    level->spikeHeads = (const LevelSpikeHead *)(data + header->spikeHeadOffset);
+    level->enemies = (const LevelEnemy *)(data + header->enemyOffset);
+    level->cannons = (const LevelCannon *)(data + header->cannonOffset);
+    level->chunks = (const LevelChunk *)(data + header->chunkOffset);
+    level->platformKinds = data + header->platformKindOffset;
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) level->tiles[layer] = data + header->tileOffset[layer];
+
+    return true;
+}
+
+void UnloadLevel(Level *level)
+{
+    UnmapFile(&level->file);
+    *level = (Level){ 0 };
+}
+
+int GetLevelChunk(const Level *level, float x)
+{
+    int chunk = (int)floorf(x/LEVEL_CHUNK_WIDTH);
+    if (chunk < 0) return 0;
+    if (chunk >= level->header->chunkCount) return level->header->chunkCount - 1;
+    return chunk;
+}
+
+int GetLevelTile(const Level *level, TileLayer layer, int col, int row)
+{
+    const LevelHeader *header = level->header;
+    if (col < 0 || row < 0 || col >= header->tileCols || row >= header->tileRows) return 0;
+    return level->tiles[layer][col*header->tileRows + row];
+}
+
+void PrefetchLevelChunk(const Level *level, int chunk)
+{
+    const LevelHeader *header = level->header;
+    if (chunk < 0 || chunk >= header->chunkCount) return;
+
+    const LevelChunk *begin = &level->chunks[chunk], *end = &level->chunks[chunk + 1];
+    PrefetchFile(&level->file, header->platformOffset + begin->platformFirst*sizeof(Rectangle),
+                 (end->platformFirst - begin->platformFirst)*sizeof(Rectangle));
+    PrefetchFile(&level->file, header->diamondOffset + begin->diamondFirst*sizeof(Vector2),
+                 (end->diamondFirst - begin->diamondFirst)*sizeof(Vector2));
+    PrefetchFile(&level->file, header->spikeHeadOffset + begin->spikeHeadFirst*sizeof(LevelSpikeHead),
+                 (end->spikeHeadFirst - begin->spikeHeadFirst)*sizeof(LevelSpikeHead));
+    PrefetchFile(&level->file, header->enemyOffset + begin->enemyFirst*sizeof(LevelEnemy),
+                 (end->enemyFirst - begin->enemyFirst)*sizeof(LevelEnemy));
+    PrefetchFile(&level->file, header->cannonOffset + begin->cannonFirst*sizeof(LevelCannon),
+                 (end->cannonFirst - begin->cannonFirst)*sizeof(LevelCannon));
+
+    // Tile columns of the chunk
+    const int chunkCols = LEVEL_CHUNK_WIDTH/TILE_SIZE;
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) {
+        PrefetchFile(&level->file, header->tileOffset[layer] + (size_t)chunk*chunkCols*header->tileRows,
+                     (size_t)chunkCols*header->tileRows);
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "raylib.h"
+#include "mapfile.h"
+
+// Binary level (.lvl): a header followed by flat entity tables. The file
+// is memory-mapped and the tables are used in place, with no parsing.
+// Build one from the readable text source with tools/make_level.c.
+#define LEVEL_MAGIC 0x314c564c      // "LVL1"
+#define LEVEL_VERSION 5
+
+// The world is split into vertical strips of LEVEL_CHUNK_WIDTH pixels.
+// Entities are sorted by x, so each chunk owns a contiguous range of every
+// table and only the chunks around the player need to be touched.
+#define LEVEL_CHUNK_WIDTH 1024
+
+// Tile layers: one byte per TILE_SIZE cell, 0 for empty, otherwise the
+// tileset index + 1. Stored column-major, so a chunk's tiles are contiguous.
+#define TILE_SIZE 32
+
+typedef enum {
+    TILE_LAYER_TERRAIN,         // Terrain (32x32).png, its top faces are walkable
+    TILE_LAYER_DECORATIONS,     // Decorations (32x32).png, drawn only
+    TILE_LAYER_COUNT
+} TileLayer;
+
+// What a collision rectangle looks like: only sprite platforms draw
+// themselves, the others are part of the ground or the terrain tiles
+typedef enum {
+    PLATFORM_SPRITE,
+    PLATFORM_GROUND,
+    PLATFORM_TERRAIN            // merged top face of a run of terrain tiles
+} PlatformKind;
+
+// Enemy types, each with its own behaviour (see enemies.c)
+typedef enum {
+    ENEMY_KING_PIG,
+    ENEMY_PIG,
+    ENEMY_BOX_PIG,              // throws boxes
+    ENEMY_BOMB_PIG,             // throws bombs
+    ENEMY_HIDING_PIG,           // hides in its box
+    ENEMY_KIND_COUNT
+} EnemyKind;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    float worldWidth;
+    float worldHeight;
+    float groundY;          // top of the ground strip
+    Vector2 spawn;          // player sprite position
+    int platformCount;
+    int diamondCount;
+    int spikeHeadCount;
+    int platformOffset;     // byte offsets from the start of the file
+    int diamondOffset;
+    int spikeHeadOffset;
+    int chunkCount;
+    int chunkOffset;
+    int platformKindOffset;     // one byte per platform
+    int tileCols;
+    int tileRows;
+    int tileOffset[TILE_LAYER_COUNT];
+    int enemyCount;
+    int enemyOffset;
+    int cannonCount;
+    int cannonOffset;
+} LevelHeader;
+
+typedef struct {
+    float x;
+    float y;
+    float minY;             // top of the patrol
+} LevelSpikeHead;
+
+typedef struct {
+    float x;                // hitbox top-left at spawn
+    float y;
+    int kind;               // EnemyKind
+} LevelEnemy;
+
+typedef struct {
+    float x;                // sprite top-left
+    float y;
+    int facing;             // -1 fires left, 1 right
+    float period;           // seconds between shots
+} LevelCannon;
+
+// First entity of each table whose x falls inside the chunk. The table has
+// chunkCount + 1 entries, the last one closes the ranges of the last chunk.
+// The ground (platform 0) spans the world and belongs to no chunk.
+typedef struct {
+    int platformFirst;
+    int diamondFirst;
+    int spikeHeadFirst;
+    int enemyFirst;         // by spawn x, enemies stay within a leash of it
+    int cannonFirst;
+} LevelChunk;
+
+typedef struct {
+    const LevelHeader *header;
+    const Rectangle *platforms;
+    const Vector2 *diamonds;
+    const LevelSpikeHead *spikeHeads;
+    const LevelEnemy *enemies;
+    const LevelCannon *cannons;
+    const LevelChunk *chunks;
+    const unsigned char *platformKinds;
+    const unsigned char *tiles[TILE_LAYER_COUNT];
+    MappedFile file;
+} Level;
+
+#define DEFAULT_LEVEL_PATH "levels/level1.lvl"
+
+// Map and validate a .lvl file, false if it is missing or malformed
+bool LoadLevel(const char *path, Level *level);
+void UnloadLevel(Level *level);
+
+// Chunk under a world x, clamped to the level
+int GetLevelChunk(const Level *level, float x);
+
+// Tile at a cell of a layer, 0 for empty or outside the level
+int GetLevelTile(const Level *level, TileLayer layer, int col, int row);
+
+// Ask the OS to start reading the chunk's entity tables in the background,
+// so the first access after it activates does not stall on a page fault
+void PrefetchLevelChunk(const Level *level, int chunk);
+
+#endif
@@ -1,457 +1,189 @@
 #include "raylib.h"
-#define MAX_PLATFORMS 50
-#define MAX_DIAMONDS 10
-#define MAX_SPIKEHEADS 3
-
-typedef enum {
-    PLAYER_IDLE,
-    PLAYER_RUN,
-    PLAYER_JUMP,
-    PLAYER_FALL,
-    PLAYER_HIT
-} PlayerState;
+#include "game.h"
+#include "render.h"
+#include "level.h"
+#include "profile.h"
+#include "replay.h"
+#include "jobs.h"
+#include "simthread.h"
+
+#include <string.h>
+
+// GL upload time per frame while loading, keeps the loading screen responsive
+#define ASSET_UPLOAD_BUDGET 0.004
+
+int main(int argc, char **argv) {
+    const char *levelPath = DEFAULT_LEVEL_PATH;
+    const char *tracePath = PROFILE_TRACE_DEFAULT_PATH;
+    const char *recordPath = NULL;
+
+    // game [level.lvl] [--trace[=trace.json]] [--record[=session.rpl]]
+    // --trace records a timeline from startup, --record logs every tick's input
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--trace", 7) == 0) {
+            if (argv[i][7] == '=') tracePath = argv[i] + 8;
+            StartProfileTrace();
+        } else if (strncmp(argv[i], "--record", 8) == 0) {
+            recordPath = (argv[i][8] == '=') ? argv[i] + 9 : REPLAY_DEFAULT_PATH;
+        } else {
+            levelPath = argv[i];
+        }
+    }
 
-int main(void) {
-    const int SCREEN_WIDTH = 1000;
-    const int SCREEN_HEIGHT = 700;
-    const int WORLD_WIDTH = 3000;
+    Level level;
+    PROFILE_BEGIN(PROFILE_LOAD_LEVEL);
+    bool levelLoaded = LoadLevel(levelPath, &level);
+    PROFILE_END(PROFILE_LOAD_LEVEL);
+    if (!levelLoaded) {
+        TraceLog(LOG_ERROR, "LEVEL: [%s] Missing or not a valid level file", levelPath);
+        return 1;
+    }
 
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Platformer Game");
-    SetTargetFPS(60);
-
-    // Load and resize sprite sheets
-    Image imgIdle = LoadImage("Sprites/01-KingHuman/idle.png");
-    Image imgRun  = LoadImage("Sprites/01-KingHuman/run.png");
-    Image imgJump = LoadImage("Sprites/01-KingHuman/jump.png");
-    Image imgFall = LoadImage("Sprites/01-KingHuman/fall.png");
-    Image imgHit = LoadImage("Sprites/01-KingHuman/Hit.png");
-
-    Image background = LoadImage("Sprites/Background/Blue.png");
-    Image ground = LoadImage("Sprites/ground.png");
-    Image platform = LoadImage("Sprites/platform.png");
-    Image diamond = LoadImage("Sprites/Diamond.png");
-
-    Image spikeHead = LoadImage("Sprites/enemy/idle.png");
-
-    ImageResize(&imgIdle, imgIdle.width * 2, imgIdle.height * 2);
-    ImageResize(&imgRun,  imgRun.width  * 2, imgRun.height  * 2);
-    ImageResize(&imgJump, imgJump.width * 2, imgJump.height * 2);
-    ImageResize(&imgFall, imgFall.width * 2, imgFall.height * 2);
-    ImageResize(&imgHit, imgHit.width * 2, imgHit.height * 2);
-    ImageResize(&ground , ground.width * 2 , ground.height * 2);
-    ImageResize(&diamond , diamond.width * 2 , diamond.height * 2);
-    ImageResize(&spikeHead , spikeHead.width * 1.5 , spikeHead.height * 1.5);
-
-    Texture2D texIdle = LoadTextureFromImage(imgIdle);
-    Texture2D texRun  = LoadTextureFromImage(imgRun);
-    Texture2D texJump = LoadTextureFromImage(imgJump);
-    Texture2D texFall = LoadTextureFromImage(imgFall);
-    Texture2D texHit = LoadTextureFromImage(imgHit);
-    Texture2D texBackground = LoadTextureFromImage(background);
-    Texture2D texGround = LoadTextureFromImage(ground);
-    Texture2D texPlatform = LoadTextureFromImage(platform);
-    Texture2D texDiamond = LoadTextureFromImage(diamond);
-    Texture2D texSpikeHead = LoadTextureFromImage(spikeHead);
-
-    UnloadImage(imgIdle);
-    UnloadImage(imgRun);
-    UnloadImage(imgJump);
-    UnloadImage(imgFall);
-    UnloadImage(imgHit);
-    UnloadImage(background);
-    UnloadImage(ground);
-    UnloadImage(platform);
-    UnloadImage(diamond);
-    UnloadImage(spikeHead);
-
-    // Frame sizes
-    const int FRAME_WIDTH = 78 * 2;
-    const int FRAME_HEIGHT = texIdle.height;
-
-    int idleFrameCount = texIdle.width / FRAME_WIDTH;
-    int runFrameCount  = texRun.width  / FRAME_WIDTH;
-    int jumpFrameCount = texJump.width / FRAME_WIDTH;
-    int fallFrameCount = texFall.width / FRAME_WIDTH;
-    int hitFrameCount  = texHit.width  / FRAME_WIDTH;
-
-    // Player hitbox
-    float hitboxOffsetX = 30;
-    float hitboxOffsetY = 40;
-    float hitboxWidth   = 60;
-    float hitboxHeight  = 48;
-
-    Rectangle player = {100 + hitboxOffsetX, 300 + hitboxOffsetY, hitboxWidth, hitboxHeight};
-    int player_lives = 3;
-    float velocityY = 0;
-    const float gravity = 0.5f;
-    const float jumpForce = -12.0f;
-    bool onGround = false;
-    bool facingRight = true;
-
-    // Animation properties
-    int frame = 0;
-    float frameSpeed = 0.15f;
-    float frameTimer = 0;
-    PlayerState state = PLAYER_IDLE;
-
-    // Player hit/stun - FIXED: removed duplicate declaration
-    bool playerHit = false;
-    float hitTimer = 0.0f;
-    const float hitDuration = 0.6f; // seconds of stun / animation
-    int hitFrame = 0;
-
-    // Diamond animation properties
-    const int DIAMOND_FRAME_WIDTH = 18 * 2; 
-    const int DIAMOND_FRAME_HEIGHT = texDiamond.height;
-    const int DIAMOND_FRAME_COUNT = 10;
-    float diamondFrameTimer[MAX_DIAMONDS] = {0};
-    float diamondFrameSpeed = 0.15f; // FIXED: consistent naming
-    int diamondFrame[MAX_DIAMONDS] = {0};
+    SetTargetFPS(60);   // render rate only, gameplay runs at TICK_RATE
 
-    // Spike Head properties
-    Rectangle spikeHeads[MAX_SPIKEHEADS] = {
-        {422, 470, 78, texSpikeHead.height},
-        {822, 300, 78, texSpikeHead.height},
-        {1550, 320, 78, texSpikeHead.height}
-    };
-    float spikeMinY[MAX_SPIKEHEADS] = {320, 380, 320};
-    float spikeAmplitude = 200; 
-    float spikeSpeedDown = 6.0f;
-    float spikeSpeedUp = 2.0f;
-    bool spikeGoingDown[MAX_SPIKEHEADS] = {true, true, true};
-
-    // Camera
-    Camera2D camera = {0};
-    camera.target = (Vector2){ player.x + player.width/2, player.y + player.height/2 };
-    camera.offset = (Vector2){ SCREEN_WIDTH/2.0f, SCREEN_HEIGHT/2.0f };
-    camera.rotation = 0.0f;
-    camera.zoom = 1.0f;
-
-    // FIXED: Added missing cameraDefaultOffset
-    Vector2 cameraDefaultOffset = camera.offset;
-
-    // Camera shake
-    float shakeTimer = 0.0f;
-    const float shakeDuration = 0.15f;
-    const int shakeMagnitude = 6;
-
-    // Platforms - Enhanced level design
-    Rectangle platforms[MAX_PLATFORMS] = {
-        { 0, SCREEN_HEIGHT - 50, WORLD_WIDTH, 50 },     // Ground
-
-        { 250, 550, 96, 20 },     // First jump
-        { 250, 350, 96, 20 }, 
-        { 500, 470, 96, 20 },      
-        { 500, 270, 96, 20 }, 
-        { 700, 350, 96, 20 },     
+    InitJobSystem(-1);     // one worker per extra core
 
+    Game game;
+    if (!InitGame(&game, &level)) {
+        TraceLog(LOG_ERROR, "GAME: Failed to set up level [%s]", levelPath);
+        UnloadLevel(&level);
+        ShutdownJobSystem();
+        CloseWindow();
+        return 1;
+    }
 
-        { 900, 470, 96, 20 },     // Landing platform
-        { 986, 470, 96, 20 }, 
+    // Sprites decode on a loader thread while the window shows a loading
+    // screen; each frame spends at most ASSET_UPLOAD_BUDGET on texture uploads
+    AtlasLoader atlasLoader;
+    StartAtlasLoad(&atlasLoader);
+    bool loaded = UpdateAtlasLoad(&atlasLoader, ASSET_UPLOAD_BUDGET);
+    while (!loaded && !WindowShouldClose()) {
+        BeginDrawing();
+            ClearBackground(SKYBLUE);
+            DrawLoadingScreen(GetAtlasLoadProgress(&atlasLoader));
+        EndDrawing();
+        loaded = UpdateAtlasLoad(&atlasLoader, ASSET_UPLOAD_BUDGET);
+    }
 
-        { 1150, 650, 96, 20 },
-        { 1150, 630, 96, 20 },
-        { 1150, 610, 96, 20 },
-        { 1150, 590, 96, 20 },
-        { 1150, 570, 96, 20 },
-        { 1150, 550, 96, 20 },     
-        { 1150, 530, 96, 20 },
-        { 1150, 510, 96, 20 },
-        { 1150, 490, 96, 20 },
-        { 1150, 470, 96, 20 },
-        { 1150, 450, 96, 20 },
-        { 1150, 430, 96, 20 },
-        { 1150, 410, 96, 20 },
-        { 1150, 390, 96, 20 },
+    if (!loaded || atlasLoader.atlas.texture.id == 0) {
+        if (!loaded) CancelAtlasLoad(&atlasLoader);     // window closed mid-load
+        else TraceLog(LOG_ERROR, "ATLAS: Failed to load sprites");
+        UnloadGame(&game);
+        UnloadLevel(&level);
+        ShutdownJobSystem();
+        CloseWindow();
+        return loaded ? 1 : 0;
+    }
 
-        { 1400, 470, 96, 20 },     // Continuing down
-        { 1650, 550, 96, 20 }     // Final platform
-    };
+    Renderer renderer;
+    if (!InitRenderer(&renderer, &game, atlasLoader.atlas)) {
+        TraceLog(LOG_ERROR, "RENDER: Failed to set up the renderer");
+        UnloadGame(&game);
+        UnloadLevel(&level);
+        ShutdownJobSystem();
+        CloseWindow();
+        return 1;
+    }
 
-    // Diamonds - Strategic placement
-    Rectangle diamonds[MAX_DIAMONDS] = {
-        {286, 500, 25, 25},    // First platform
-        {286, 300, 25, 25},    // Second platform  
-        {536, 420, 25, 25},    // Third platform
-        {536, 220, 25, 25},    // Fourth platform
-        {736, 300, 25, 25},   // Fifth platform
-        {936, 420, 25, 25},
-        {1022, 420, 25, 25},
-        
-    };
+    // From here on the game belongs to the simulation thread, the main
+    // thread only draws its snapshots
+    InputLog inputLog = {0};
+    SimThread sim;
+    if (!StartSimThread(&sim, &game, (recordPath != NULL) ? &inputLog : NULL)) {
+        TraceLog(LOG_ERROR, "GAME: Failed to start the simulation thread");
+        UnloadRenderer(&renderer);
+        UnloadGame(&game);
+        UnloadLevel(&level);
+        ShutdownJobSystem();
+        CloseWindow();
+        return 1;
+    }
 
-    int score = 0;
+    bool showProfiler = false;
 
     while (!WindowShouldClose()) {
-
-        float dt = GetFrameTime();
-
-        // Update hit timer if player is hit
-        if (playerHit) {
-            hitTimer += dt;
-            if (hitTimer >= hitDuration) {
-                playerHit = false;
-                hitTimer = 0.0f;
-            }
-        }
-
-        // Apply gravity
-        velocityY += gravity;
-        player.y += velocityY;
-        onGround = false;
-
-        // Collision with platforms
-        for (int i = 0; i < MAX_PLATFORMS; i++) {
-            if (CheckCollisionRecs(player, platforms[i])) {
-                // Ensure only land when coming from above
-                if (velocityY > 0 && player.y + player.height - velocityY <= platforms[i].y) {
-                    player.y = platforms[i].y - player.height;
-                    velocityY = 0;
-                    onGround = true;
-                }
-            }
-        }
-
-        // Jump
-        if (!playerHit && onGround && IsKeyPressed(KEY_SPACE)) {
-            velocityY = jumpForce;
-            onGround = false;
-        }
-
-        // Movement (disabled during hit)
-        bool moving = false;
-        if (!playerHit) {
-            if (IsKeyDown(KEY_D)) { player.x += 5; facingRight = true; moving = true; }
-            if (IsKeyDown(KEY_A)) { player.x -= 5; facingRight = false; moving = true; }
-        }
-
-        // World bounds
-        if (player.x < 0) player.x = 0;
-        if (player.x + player.width > WORLD_WIDTH) player.x = WORLD_WIDTH - player.width;
-
-        // Camera bounds and follow
-        float targetX = player.x + player.width/2;
-        float targetY = player.y + player.height/2;
-        if (targetX < SCREEN_WIDTH/2) targetX = SCREEN_WIDTH/2;
-        if (targetX > WORLD_WIDTH - SCREEN_WIDTH/2) targetX = WORLD_WIDTH - SCREEN_WIDTH/2;
-        if (targetY < SCREEN_HEIGHT/2) targetY = SCREEN_HEIGHT/2;
-        if (targetY > SCREEN_HEIGHT/2) targetY = SCREEN_HEIGHT/2;
-        camera.target = (Vector2){ targetX, targetY };
-
-        // Spike Head movement and collision
-        for (int i = 0; i < MAX_SPIKEHEADS; i++) {
-            if (spikeGoingDown[i]) {
-                spikeHeads[i].y += spikeSpeedDown;
-                if (spikeHeads[i].y >= spikeMinY[i] + spikeAmplitude)
-                    spikeGoingDown[i] = false;
+        PROFILE_BEGIN(PROFILE_FRAME);
+
+        // Sample input once per rendered frame
+        GameInput input = {
+            .left = IsKeyDown(KEY_A),
+            .right = IsKeyDown(KEY_D),
+            .jump = IsKeyPressed(KEY_SPACE),
+            .restart = IsKeyPressed(KEY_R)
+        };
+        SetSimInput(&sim, &input);
+        if (IsKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+        if (IsKeyPressed(KEY_F4)) {
+            if (!IsProfileTracing()) {
+                StartProfileTrace();
+                TraceLog(LOG_INFO, "PROFILE: Recording trace");
+            } else if (StopProfileTrace(tracePath)) {
+                TraceLog(LOG_INFO, "PROFILE: [%s] Trace written", tracePath);
             } else {
-                spikeHeads[i].y -= spikeSpeedUp;
-                if (spikeHeads[i].y <= spikeMinY[i])
-                    spikeGoingDown[i] = true;
-            }
-
-            // Collision triggers hit (only if not already stunned)
-            if (CheckCollisionRecs(player, spikeHeads[i]) && !playerHit) {
-                playerHit = true;
-                hitTimer = 0.0f;
-                hitFrame = 0;
-                player_lives -= 1;
-                // Knockback & slight bounce
-                velocityY = -6.0f;
-                if (facingRight) player.x -= 24; else player.x += 24;
-                // Start camera shake
-                shakeTimer = shakeDuration;
+                TraceLog(LOG_WARNING, "PROFILE: [%s] Failed to write trace", tracePath);
             }
         }
 
-        // Player animation state
-        if (playerHit) state = PLAYER_HIT;
-        else if (!onGround) state = (velocityY < 0) ? PLAYER_JUMP : PLAYER_FALL;
-        else if (moving) state = PLAYER_RUN;
-        else state = PLAYER_IDLE;
-
-        // Animation update - FIXED: proper frame timing
-        if (state != PLAYER_HIT) {
-            frameTimer += dt;
-            if (frameTimer >= frameSpeed) {
-                frameTimer = 0;
-                frame++;
-            }
-        } else {
-            // Update player hit frames based on hit timer
-            float t = hitTimer / hitDuration;
-            if (t < 0) t = 0;
-            if (t > 1) t = 1;
-            hitFrame = (int)(t * (hitFrameCount - 1));
-        }
+        // Sprites edited on disk are swapped in place
+        UpdateAssetReload(&renderer);
 
-        // Select the current texture & frameCount for the state
-        int frameCount = 1;
-        Texture2D currentTexture = texIdle;
-        switch(state){
-            case PLAYER_IDLE: frameCount = idleFrameCount; currentTexture = texIdle; break;
-            case PLAYER_RUN:  frameCount = runFrameCount;  currentTexture = texRun;  break;
-            case PLAYER_JUMP: frameCount = jumpFrameCount; currentTexture = texJump; break;
-            case PLAYER_FALL: frameCount = fallFrameCount; currentTexture = texFall; break;
-            case PLAYER_HIT:  frameCount = hitFrameCount;  currentTexture = texHit;  break;
-        }
-        
-        // Reset frame counter if needed
-        if(state != PLAYER_HIT && frame >= frameCount) frame = 0;
-        
-        // Build source rectangle for player sprite
-        Rectangle sourceRec = { (state == PLAYER_HIT ? hitFrame : frame) * FRAME_WIDTH, 0, 
-                               facingRight ? FRAME_WIDTH : -FRAME_WIDTH, FRAME_HEIGHT };
+        // Latest finished tick, blended towards it by how long ago it was due
+        const GameSnapshot *snapshot = AcquireSnapshot(&sim);
+        float alpha = (float)((GetProfileTime() - snapshot->time)/TICK_DT);
+        if (alpha < 0.0f) alpha = 0.0f;
+        if (alpha > 1.0f) alpha = 1.0f;
 
-        // Diamond collisions & animation - FIXED: consistent variable naming
-        for (int i = 0; i < MAX_DIAMONDS; i++) {
-            if (diamonds[i].width > 0 && CheckCollisionRecs(player, diamonds[i])) {
-                score++;
-                diamonds[i].width = 0;
-                diamonds[i].height = 0;
-            }
-            if (diamonds[i].width > 0) {
-                diamondFrameTimer[i] += dt;
-                if (diamondFrameTimer[i] >= diamondFrameSpeed) { // FIXED: diamondFrameSpeed not diamondFrameTime
-                    diamondFrameTimer[i] = 0;
-                    diamondFrame[i]++;
-                    if (diamondFrame[i] >= DIAMOND_FRAME_COUNT) diamondFrame[i] = 0;
-                }
-            }
-        }
+        PROFILE_BEGIN(PROFILE_CAMERA);
+        UpdateRenderCamera(&renderer, snapshot, alpha);
+        PROFILE_END(PROFILE_CAMERA);
+        UpdateStaticLayer(&renderer);
 
-        // Camera shake application
-        if (shakeTimer > 0.0f) {
-            shakeTimer -= dt;
-            camera.offset.x = cameraDefaultOffset.x + (float)(GetRandomValue(-shakeMagnitude, shakeMagnitude));
-            camera.offset.y = cameraDefaultOffset.y + (float)(GetRandomValue(-shakeMagnitude, shakeMagnitude));
-        } else {
-            camera.offset = cameraDefaultOffset;
-        }
+        PROFILE_BEGIN(PROFILE_PARTICLES);
+        UpdateParticleEffects(&renderer, snapshot, GetFrameTime());
+        PROFILE_END(PROFILE_PARTICLES);
 
         BeginDrawing();
             ClearBackground(SKYBLUE);
-            BeginMode2D(camera);
-
-                // Draw tiled background
-                for (int x = 0; x < WORLD_WIDTH; x += texBackground.width) {
-                    for (int y = 0; y < SCREEN_HEIGHT; y += texBackground.height) {
-                        DrawTexture(texBackground, x, y, WHITE);
-                    }
-                }
-
-                // Draw platforms
-                for (int i = 0; i < MAX_PLATFORMS; i++) {
-                    DrawTexture(texPlatform, platforms[i].x, platforms[i].y, WHITE);
-                    // Draw platform hitboxes
-                    //DrawRectangleLinesEx(platforms[i], 2, GREEN);
-                }
-
-                // Draw ground along bottom
-                for(int x = 0; x < WORLD_WIDTH; x += texGround.width) {
-                    DrawTexture(texGround, x, platforms[0].y, WHITE);
-                }
 
-                // Draw spikeheads
-                for (int i = 0; i < MAX_SPIKEHEADS; i++) {
-                    DrawTexture(texSpikeHead, spikeHeads[i].x, spikeHeads[i].y, WHITE);
-                    // Draw spikehead hitboxes
-                    //DrawRectangleLinesEx(spikeHeads[i], 2, ORANGE);
-                }
-                
-                // Draw diamonds with animation
-                for (int i = 0; i < MAX_DIAMONDS; i++) {
-                    if (diamonds[i].width > 0) {
-                        Rectangle sourceRecDiamond = {
-                            diamondFrame[i] * DIAMOND_FRAME_WIDTH, 0, DIAMOND_FRAME_WIDTH, DIAMOND_FRAME_HEIGHT
-                        };
-                        DrawTextureRec(texDiamond, sourceRecDiamond, (Vector2){ diamonds[i].x -10, diamonds[i].y }, WHITE);
-                        // Draw diamond hitboxes
-                        //DrawRectangleLinesEx(diamonds[i], 2, YELLOW);
-                    }
-                }
+            PROFILE_BEGIN(PROFILE_DRAW_WORLD);
+            DrawWorld(&renderer, snapshot, alpha);
+            PROFILE_END(PROFILE_DRAW_WORLD);
 
-                // Draw player
-                Vector2 drawPos = { player.x - hitboxOffsetX, player.y - hitboxOffsetY };
-                if (!facingRight) drawPos.x = player.x - hitboxOffsetX - player.width/2 - 5;
-                DrawTextureRec(currentTexture, sourceRec, drawPos, WHITE);
-                // Draw player hitbox
-                //DrawRectangleLinesEx(player, 2, RED);
+            PROFILE_BEGIN(PROFILE_DRAW_HUD);
+            DrawHud(snapshot);
+            if (showProfiler) DrawProfilerOverlay(&renderer);
+            PROFILE_END(PROFILE_DRAW_HUD);
 
-            EndMode2D();
-
-            // UI: score & instructions
-            DrawText(TextFormat("Score: %d/%d", score, MAX_DIAMONDS), 10, 40, 20, BLACK);
-            DrawText("Press SPACE to jump", 10, 10, 20, BLACK);
-            DrawText("Use A and D to move", 10, 70, 20, BLACK);
+        PROFILE_BEGIN(PROFILE_SWAP);
+        EndDrawing();
+        PROFILE_END(PROFILE_SWAP);
 
-            // Draw lives as hearts (simple circles)
-            for (int i = 0; i < player_lives; i++) {
-                DrawCircle(30 + i * 30, 120, 10, RED);
-            }
-            DrawText("Lives", 10, 95, 12, BLACK);
+        PROFILE_END(PROFILE_FRAME);
+        EndProfileFrame();
+    }
 
-            // Win condition
-            if (score == MAX_DIAMONDS) {
-                DrawText("LEVEL COMPLETE!", SCREEN_WIDTH/2 - 150, SCREEN_HEIGHT/2 - 50, 40, GREEN);
-                DrawText("All diamonds collected!", SCREEN_WIDTH/2 - 120, SCREEN_HEIGHT/2, 30, GREEN);
-                DrawText("Press R to Restart", SCREEN_WIDTH/2 - 100, SCREEN_HEIGHT/2 + 40, 20, BLACK);
-                if (IsKeyPressed(KEY_R)) {
-                    // Reset level
-                    score = 0;
-                    player_lives = 3;
-                    player.x = 100 + hitboxOffsetX;
-                    player.y = 300 + hitboxOffsetY;
-                    velocityY = 0;
-                    playerHit = false;
-                    hitTimer = 0;
-                    for (int i = 0; i < MAX_DIAMONDS; i++) {
-                        diamonds[i].width = 25;
-                        diamonds[i].height = 25;
-                        diamondFrame[i] = 0;
-                        diamondFrameTimer[i] = 0;
-                    }
-                }
-            }
+    StopSimThread(&sim);
 
-            // Lose condition & restart prompt
-            if (player_lives <= 0) {
-                DrawText("YOU DIED!", SCREEN_WIDTH/2 - 150, SCREEN_HEIGHT/2 - 50, 40, RED);
-                DrawText("Press R to Restart", SCREEN_WIDTH/2 - 100, SCREEN_HEIGHT/2 + 10, 20, BLACK);
-                if (IsKeyPressed(KEY_R)) {
-                    // Reset everything
-                    score = 0;
-                    player_lives = 3;
-                    player.x = 100 + hitboxOffsetX;
-                    player.y = 300 + hitboxOffsetY;
-                    velocityY = 0;
-                    playerHit = false;
-                    hitTimer = 0;
-                    frame = 0;
-                    for (int i = 0; i < MAX_DIAMONDS; i++) {
-                        diamonds[i].width = 25;
-                        diamonds[i].height = 25;
-                        diamondFrame[i] = 0;
-                        diamondFrameTimer[i] = 0;
-                    }
-                }
-            }
+    if (IsProfileTracing()) {
+        if (StopProfileTrace(tracePath)) TraceLog(LOG_INFO, "PROFILE: [%s] Trace written", tracePath);
+        else TraceLog(LOG_WARNING, "PROFILE: [%s] Failed to write trace", tracePath);
+    }
 
-        EndDrawing();
+    if (recordPath != NULL) {
+        if (SaveInputLog(&inputLog, recordPath, &level, levelPath, &game))
+            TraceLog(LOG_INFO, "REPLAY: [%s] %i ticks recorded", recordPath, inputLog.count);
+        else if (inputLog.failed) TraceLog(LOG_WARNING, "REPLAY: [%s] Out of memory after %i ticks, input log not written", recordPath, inputLog.count);
+        else TraceLog(LOG_WARNING, "REPLAY: [%s] Failed to write input log", recordPath);
+        FreeInputLog(&inputLog);
     }
 
     // Cleanup
-    UnloadTexture(texIdle);
-    UnloadTexture(texRun);
-    UnloadTexture(texJump);
-    UnloadTexture(texFall);
-    UnloadTexture(texHit);
-    UnloadTexture(texBackground);
-    UnloadTexture(texGround);
-    UnloadTexture(texPlatform);
-    UnloadTexture(texDiamond);
-    UnloadTexture(texSpikeHead);
+    UnloadRenderer(&renderer);
+    UnloadGame(&game);
+    UnloadLevel(&level);
+    ShutdownJobSystem();
 
     CloseWindow();
     return 0;
-}
\ No newline at end of file
+}
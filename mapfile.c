@@ -0,0 +1,102 @@
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #define _POSIX_C_SOURCE 200112L
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "mapfile.h"
+
+#if defined(_WIN32)
+
+int MapFile(const char *path, MappedFile *file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) return 0;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) { CloseHandle(fileHandle); return 0; }
+
+    HANDLE mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fileHandle);
+    if (mapping == NULL) return 0;
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) { CloseHandle(mapping); return 0; }
+
+    file->data = data;
+    file->size = (size_t)size.QuadPart;
+    file->handle = mapping;
+    return 1;
+}
+
+void UnmapFile(MappedFile *file)
+{
+    if (file->data != NULL) UnmapViewOfFile(file->data);
+    if (file->handle != NULL) CloseHandle((HANDLE)file->handle);
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+}
+
+void PrefetchFile(const MappedFile *file, size_t offset, size_t size)
+{
+    if (file->data == NULL || offset >= file->size) return;
+    if (size > file->size - offset) size = file->size - offset;
+
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0602)
+    WIN32_MEMORY_RANGE_ENTRY range = { (char *)file->data + offset, size };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+}
+
+#else
+
+int MapFile(const char *path, MappedFile *file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return 0; }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return 1;
+}
+
+void UnmapFile(MappedFile *file)
+{
+    if (file->data != NULL) munmap((void *)file->data, file->size);
+    file->data = NULL;
+    file->size = 0;
+}
+
+void PrefetchFile(const MappedFile *file, size_t offset, size_t size)
+{
+    if (file->data == NULL || offset >= file->size) return;
+    if (size > file->size - offset) size = file->size - offset;
+
+    // The advice range has to start on a page boundary
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset - offset%page;
+    posix_madvise((char *)file->data + start, size + (offset - start), POSIX_MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file. Kept apart from raylib.h
+// because windows.h clashes with raylib names.
+typedef struct {
+    const void *data;
+    size_t size;
+    void *handle;       // platform mapping handle
+} MappedFile;
+
+int MapFile(const char *path, MappedFile *file);    // returns 0 on failure
+void UnmapFile(MappedFile *file);
+
+// Hint that [offset, offset + size) will be read soon. The OS pages it in
+// asynchronously; does nothing where the platform has no such hint.
+void PrefetchFile(const MappedFile *file, size_t offset, size_t size);
+
+#endif
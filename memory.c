@@ -0,0 +1,134 @@
+#include "memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Block headers are padded so the data after them stays aligned
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+static unsigned char *GetBlockData(ArenaBlock *block)
+{
+    return (unsigned char *)block + BLOCK_HEADER;
+}
+
+void InitArena(Arena *arena, size_t blockSize)
+{
+    *arena = (Arena){ 0 };
+    arena->blockSize = (blockSize > 0) ? blockSize : ARENA_BLOCK_SIZE;
+}
+
+void FreeArena(Arena *arena)
+{
+    ArenaBlock *block = arena->first;
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    // Walk forward through blocks kept from before the last reset; the ones
+    // skipped for being too small are reused after the next reset
+    ArenaBlock *block = arena->current;
+    while (block != NULL && block->size - block->used < size) {
+        block = block->next;
+        if (block != NULL) block->used = 0;
+    }
+
+    if (block == NULL) {
+        size_t blockSize = (size > arena->blockSize) ? size : arena->blockSize;
+        block = malloc(BLOCK_HEADER + blockSize);
+        if (block == NULL) return NULL;
+        *block = (ArenaBlock){ NULL, blockSize, 0 };
+
+        // Append after the last block
+        ArenaBlock **link = &arena->first;
+        while (*link != NULL) link = &(*link)->next;
+        *link = block;
+    }
+
+    arena->current = block;
+    unsigned char *data = GetBlockData(block) + block->used;
+    block->used += size;
+    memset(data, 0, size);
+    return data;
+}
+
+ArenaMark GetArenaMark(const Arena *arena)
+{
+    if (arena->current == NULL) return (ArenaMark){ NULL, 0 };
+    return (ArenaMark){ arena->current, arena->current->used };
+}
+
+void ResetArena(Arena *arena, ArenaMark mark)
+{
+    if (mark.block == NULL) {
+        arena->current = arena->first;
+        if (arena->current != NULL) arena->current->used = 0;
+    } else {
+        arena->current = mark.block;
+        arena->current->used = mark.used;
+    }
+}
+
+bool InitPool(Pool *pool, Arena *arena, int itemSize, int capacity)
+{
+    *pool = (Pool){ 0 };
+
+    // Keep every item aligned like the arena
+    itemSize = (itemSize + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    pool->items = ArenaAlloc(arena, (size_t)itemSize*capacity);
+    pool->next = ArenaAlloc(arena, sizeof(int)*capacity);
+    if (pool->items == NULL || pool->next == NULL) return false;
+
+    pool->itemSize = itemSize;
+    pool->capacity = capacity;
+    ClearPool(pool);
+    return true;
+}
+
+void *PoolAlloc(Pool *pool)
+{
+    int index = pool->freeHead;
+    if (index < 0) return NULL;
+
+    pool->freeHead = pool->next[index];
+    pool->next[index] = POOL_LIVE;
+    pool->count++;
+    if (index >= pool->highWater) pool->highWater = index + 1;
+
+    void *item = pool->items + (size_t)index*pool->itemSize;
+    memset(item, 0, pool->itemSize);
+    return item;
+}
+
+void PoolFree(Pool *pool, void *item)
+{
+    int index = (int)(((unsigned char *)item - pool->items)/pool->itemSize);
+    if (index < 0 || index >= pool->capacity || pool->next[index] != POOL_LIVE) return;
+
+    pool->next[index] = pool->freeHead;
+    pool->freeHead = index;
+    pool->count--;
+}
+
+void ClearPool(Pool *pool)
+{
+    // Lowest indices first, so live items stay packed below highWater
+    for (int i = 0; i < pool->capacity; i++) pool->next[i] = (i + 1 < pool->capacity) ? i + 1 : -1;
+    pool->freeHead = (pool->capacity > 0) ? 0 : -1;
+    pool->count = 0;
+    pool->highWater = 0;
+}
+
+void *GetPoolItem(const Pool *pool, int index)
+{
+    if (pool->next[index] != POOL_LIVE) return NULL;
+    return pool->items + (size_t)index*pool->itemSize;
+}
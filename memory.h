@@ -0,0 +1,68 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Arena: bump allocator for data that lives as long as a level (or a run).
+// Memory comes from a chain of large blocks; nothing is freed one by one,
+// the whole arena is rolled back to a mark or released at once. Blocks are
+// kept across resets, so a warmed-up arena makes no more heap calls.
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *first;
+    ArenaBlock *current;
+    size_t blockSize;       // minimum size of a new block
+} Arena;
+
+typedef struct {
+    ArenaBlock *block;      // NULL for the start of the arena
+    size_t used;
+} ArenaMark;
+
+void InitArena(Arena *arena, size_t blockSize);
+void FreeArena(Arena *arena);
+
+// Zeroed, ARENA_ALIGNMENT aligned memory, NULL when the heap is exhausted
+void *ArenaAlloc(Arena *arena, size_t size);
+
+// Everything allocated after GetArenaMark is released by ResetArena
+ArenaMark GetArenaMark(const Arena *arena);
+void ResetArena(Arena *arena, ArenaMark mark);
+
+// Pool: fixed number of same-sized items for short-lived entities, carved
+// from an arena. Free items form a linked list, so spawning and despawning
+// are O(1) and never touch the heap.
+#define POOL_LIVE -2        // next[] value of an item in use
+
+typedef struct {
+    unsigned char *items;
+    int *next;              // free list links (-1 ends it), POOL_LIVE when in use
+    int itemSize;
+    int capacity;
+    int count;              // live items
+    int freeHead;
+    int highWater;          // items at or above this index were never used
+} Pool;
+
+bool InitPool(Pool *pool, Arena *arena, int itemSize, int capacity);
+
+// Zeroed item, or NULL when the pool is full
+void *PoolAlloc(Pool *pool);
+void PoolFree(Pool *pool, void *item);
+
+// Free every item at once
+void ClearPool(Pool *pool);
+
+// Live items are visited with: for (i = 0; i < pool->highWater; i++) GetPoolItem(pool, i)
+void *GetPoolItem(const Pool *pool, int index);     // NULL if the item is free
+
+#endif
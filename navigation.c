@@ -0,0 +1,360 @@
+#include "navigation.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Edge costs are the horizontal distance between span centers plus these,
+// so the horizontal distance to the goal never overestimates
+#define NAV_JUMP_COST 96.0f
+#define NAV_FALL_COST 32.0f
+#define NAV_TAKEOFF_SLACK 24.0f     // a body center stops half a body short of a platform end
+#define NAV_MAX_NEARBY 256
+
+typedef struct {
+    NavEdge *items;
+    int count;
+    int capacity;
+    bool failed;            // out of memory, an edge was dropped
+} EdgeList;
+
+static void AddEdge(EdgeList *list, int from, int to, NavEdgeType type, float takeoffX, float cost)
+{
+    if (list->failed) return;
+    if (list->count == list->capacity) {
+        int capacity = (list->capacity > 0) ? list->capacity*2 : 256;
+        NavEdge *items = realloc(list->items, capacity*sizeof(NavEdge));
+        if (items == NULL) {
+            list->failed = true;
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = (NavEdge){ from, to, type, takeoffX, cost };
+}
+
+static float GetSpanCenter(const NavSpan *span)
+{
+    return (span->x0 + span->x1)/2;
+}
+
+static int GetPieceCount(float width)
+{
+    int count = (int)ceilf(width/NAV_SPAN_WIDTH);
+    return (count > 0) ? count : 1;
+}
+
+// Seconds from a jump until the body comes back down to dy below its start
+// (dy < 0 above it), or -1 when the jump never gets that high
+static float GetJumpTime(const NavGraph *graph, float dy)
+{
+    float up = -graph->jumpForce;
+    float d = up*up + 2.0f*graph->gravity*dy;
+    if (d < 0.0f) return -1.0f;
+    return (up + sqrtf(d))/graph->gravity;
+}
+
+// Spans a jump from span s reaches: tops from just under the apex down to
+// NAV_MAX_DROP below, no further than the body drifts before coming down
+// to their height
+static void AddJumpEdges(NavGraph *graph, EdgeList *list, int s, const Rectangle *platforms, SpatialGrid *grid)
+{
+    const NavSpan *span = &graph->spans[s];
+    float apex = graph->jumpForce*graph->jumpForce/(2.0f*graph->gravity);
+    float reach = graph->airSpeed*GetJumpTime(graph, NAV_MAX_DROP);
+    Rectangle area = { span->x0 - reach, span->y - apex, span->x1 - span->x0 + 2*reach, apex + NAV_MAX_DROP };
+
+    int nearby[NAV_MAX_NEARBY];
+    int nearbyCount = QuerySpatialGrid(grid, area, nearby, NAV_MAX_NEARBY);
+    for (int n = 0; n < nearbyCount; n++) {
+        int p = nearby[n];
+        float dy = platforms[p].y - span->y;
+        if (p == span->platform || dy <= -apex || dy > NAV_MAX_DROP) continue;
+        float drift = graph->airSpeed*GetJumpTime(graph, dy);
+
+        for (int k = graph->platformSpanFirst[p]; k < graph->platformSpanFirst[p + 1]; k++) {
+            const NavSpan *target = &graph->spans[k];
+            float gap = fmaxf(0.0f, fmaxf(target->x0 - span->x1, span->x0 - target->x1));
+
+            // Platforms right below are reached by walking off an end instead
+            if (dy > 0.0f && gap <= 0.0f) continue;
+            if (drift < gap + NAV_TAKEOFF_SLACK) continue;
+
+            float takeoffX = (target->x0 >= span->x1) ? span->x1 : (target->x1 <= span->x0) ? span->x0 :
+                             (fmaxf(span->x0, target->x0) + fminf(span->x1, target->x1))/2;
+            AddEdge(list, s, k, NAV_JUMP, takeoffX, fabsf(GetSpanCenter(target) - GetSpanCenter(span)) + NAV_JUMP_COST);
+        }
+    }
+}
+
+// Walking off an end of the platform: the body drifts on at airSpeed and
+// lands on the first platform top it comes down through
+static void AddFallEdges(NavGraph *graph, EdgeList *list, int s, const Rectangle *platforms, SpatialGrid *grid)
+{
+    const NavSpan *span = &graph->spans[s];
+    int p = span->platform;
+    float reach = NAV_TAKEOFF_SLACK + graph->airSpeed*sqrtf(2.0f*NAV_MAX_DROP/graph->gravity);
+
+    for (int dir = -1; dir <= 1; dir += 2) {
+        if (dir < 0 && s != graph->platformSpanFirst[p]) continue;
+        if (dir > 0 && s != graph->platformSpanFirst[p + 1] - 1) continue;
+
+        float edgeX = (dir < 0) ? span->x0 : span->x1;
+        Rectangle area = { (dir < 0) ? edgeX - reach : edgeX, span->y, reach, NAV_MAX_DROP };
+        int nearby[NAV_MAX_NEARBY];
+        int nearbyCount = QuerySpatialGrid(grid, area, nearby, NAV_MAX_NEARBY);
+
+        float landingTime = INFINITY, landingX = 0.0f;
+        int landing = -1;
+        for (int n = 0; n < nearbyCount; n++) {
+            int q = nearby[n];
+            float dy = platforms[q].y - span->y;
+            if (q == p || dy <= 0.0f || dy > NAV_MAX_DROP) continue;
+
+            float t = sqrtf(2.0f*dy/graph->gravity);
+            float x = edgeX + dir*(NAV_TAKEOFF_SLACK + graph->airSpeed*t);
+            if (t < landingTime && x >= platforms[q].x && x <= platforms[q].x + platforms[q].width) {
+                landingTime = t;
+                landingX = x;
+                landing = q;
+            }
+        }
+        if (landing < 0) continue;
+
+        int k = GetNavSpan(graph, landing, landingX);
+        AddEdge(list, s, k, NAV_FALL, edgeX, fabsf(GetSpanCenter(&graph->spans[k]) - GetSpanCenter(span)) + NAV_FALL_COST);
+    }
+}
+
+bool BuildNavGraph(NavGraph *graph, Arena *arena, const Rectangle *platforms, int platformCount, SpatialGrid *platformGrid,
+                   float gravity, float jumpForce, float airSpeed)
+{
+    *graph = (NavGraph){ .gravity = gravity, .jumpForce = jumpForce, .airSpeed = airSpeed };
+
+    // Every platform top cut into equal pieces
+    graph->platformSpanFirst = ArenaAlloc(arena, (platformCount + 1)*sizeof(int));
+    if (graph->platformSpanFirst == NULL) return false;
+    for (int p = 0; p < platformCount; p++) {
+        graph->platformSpanFirst[p] = graph->spanCount;
+        graph->spanCount += GetPieceCount(platforms[p].width);
+    }
+    graph->platformSpanFirst[platformCount] = graph->spanCount;
+
+    graph->spans = ArenaAlloc(arena, (graph->spanCount + 1)*sizeof(NavSpan));
+    if (graph->spans == NULL) return false;
+    for (int p = 0; p < platformCount; p++) {
+        int first = graph->platformSpanFirst[p], count = graph->platformSpanFirst[p + 1] - first;
+        float width = platforms[p].width/count;
+        for (int k = 0; k < count; k++) {
+            graph->spans[first + k] = (NavSpan){
+                platforms[p].x + k*width, platforms[p].x + (k + 1)*width, platforms[p].y, p, 0, 0, true
+            };
+        }
+    }
+
+    // Edges grouped by source span. The list is load-time scratch; the
+    // graph keeps an exact-size copy.
+    EdgeList list = { 0 };
+    for (int s = 0; s < graph->spanCount; s++) {
+        NavSpan *span = &graph->spans[s];
+        span->edgeFirst = list.count;
+
+        int first = graph->platformSpanFirst[span->platform], end = graph->platformSpanFirst[span->platform + 1];
+        if (s > first) AddEdge(&list, s, s - 1, NAV_WALK, span->x0, GetSpanCenter(span) - GetSpanCenter(span - 1));
+        if (s + 1 < end) AddEdge(&list, s, s + 1, NAV_WALK, span->x1, GetSpanCenter(span + 1) - GetSpanCenter(span));
+        AddJumpEdges(graph, &list, s, platforms, platformGrid);
+        AddFallEdges(graph, &list, s, platforms, platformGrid);
+
+        span->edgeCount = list.count - span->edgeFirst;
+    }
+
+    if (list.failed) {
+        free(list.items);
+        return false;
+    }
+
+    graph->edgeCount = list.count;
+    graph->edges = ArenaAlloc(arena, (list.count + 1)*sizeof(NavEdge));
+    if (graph->edges != NULL && list.count > 0) memcpy(graph->edges, list.items, list.count*sizeof(NavEdge));
+    free(list.items);
+
+    graph->cache = ArenaAlloc(arena, NAV_CACHE_SIZE*sizeof(NavRoute));
+    graph->cost = ArenaAlloc(arena, (graph->spanCount + 1)*sizeof(float));
+    graph->cameFrom = ArenaAlloc(arena, (graph->spanCount + 1)*sizeof(int));
+    graph->visited = ArenaAlloc(arena, (graph->spanCount + 1)*sizeof(int));
+    graph->closed = ArenaAlloc(arena, (graph->spanCount + 1)*sizeof(int));
+    graph->heapCapacity = graph->edgeCount + 1;
+    graph->heap = ArenaAlloc(arena, graph->heapCapacity*sizeof(NavHeapItem));
+    if (graph->edges == NULL || graph->cache == NULL || graph->cost == NULL || graph->cameFrom == NULL ||
+        graph->visited == NULL || graph->closed == NULL || graph->heap == NULL) return false;
+
+    ClearNavCache(graph);
+    BeginNavTick(graph);
+    return true;
+}
+
+int GetNavSpan(const NavGraph *graph, int platform, float x)
+{
+    int first = graph->platformSpanFirst[platform], count = graph->platformSpanFirst[platform + 1] - first;
+    const NavSpan *span = &graph->spans[first];
+    int k = (int)floorf((x - span->x0)/(span->x1 - span->x0));
+    return first + ((k < 0) ? 0 : (k >= count) ? count - 1 : k);
+}
+
+static NavRoute *GetCacheSlot(NavGraph *graph, int start, int goal)
+{
+    unsigned int hash = (unsigned int)start*2654435761u ^ (unsigned int)goal*2246822519u;
+    return &graph->cache[(hash >> 16) & (NAV_CACHE_SIZE - 1)];
+}
+
+static void StoreRoute(NavGraph *graph, int start, int goal, int edge, unsigned long long spans, bool detour)
+{
+    *GetCacheSlot(graph, start, goal) = (NavRoute){ start, goal, edge, graph->version, spans, detour };
+}
+
+static unsigned long long GetSpanBit(int span)
+{
+    return 1ull << (span & 63);
+}
+
+// A route is stale once a span on it changed after it was stored, a
+// detour (or a goal found unreachable past a closed span) once any span
+// opened since
+static bool IsRouteValid(const NavGraph *graph, const NavRoute *route)
+{
+    if (route->detour && route->builtAt < graph->lastOpenedAt) return false;
+    if (route->edge < 0) return true;
+    for (int bit = 0; bit < 64; bit++) {
+        if (((route->spans >> bit) & 1) && graph->spanBitChangedAt[bit] > route->builtAt) return false;
+    }
+    return true;
+}
+
+static void PushHeap(NavGraph *graph, int *count, NavHeapItem item)
+{
+    NavHeapItem *heap = graph->heap;
+    int i = (*count)++;
+    while (i > 0 && heap[(i - 1)/2].priority > item.priority) {
+        heap[i] = heap[(i - 1)/2];
+        i = (i - 1)/2;
+    }
+    heap[i] = item;
+}
+
+static NavHeapItem PopHeap(NavGraph *graph, int *count)
+{
+    NavHeapItem *heap = graph->heap;
+    NavHeapItem top = heap[0];
+    NavHeapItem last = heap[--(*count)];
+
+    int i = 0;
+    for (;;) {
+        int child = 2*i + 1;
+        if (child >= *count) break;
+        if (child + 1 < *count && heap[child + 1].priority < heap[child].priority) child++;
+        if (heap[child].priority >= last.priority) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+// A* over the open spans. Every tail of a shortest route is a shortest
+// route too, so each span on the result gets its own cache entry. When a
+// closed span could have led to something shorter (its priority is a lower
+// bound on routes through it), the routes found are stored as detours.
+static int SearchRoute(NavGraph *graph, int start, int goal)
+{
+    const int search = ++graph->search;
+    const float goalX = GetSpanCenter(&graph->spans[goal]);
+    int heapCount = 0;
+    graph->searches++;
+
+    graph->cost[start] = 0.0f;
+    graph->cameFrom[start] = -1;
+    graph->visited[start] = search;
+    PushHeap(graph, &heapCount, (NavHeapItem){ fabsf(GetSpanCenter(&graph->spans[start]) - goalX), start });
+
+    bool found = false;
+    float blocked = INFINITY;       // best priority through a closed span
+    while (heapCount > 0) {
+        int s = PopHeap(graph, &heapCount).span;
+        if (graph->closed[s] == search) continue;
+        graph->closed[s] = search;
+        if (s == goal) { found = true; break; }
+
+        const NavSpan *span = &graph->spans[s];
+        for (int e = span->edgeFirst; e < span->edgeFirst + span->edgeCount; e++) {
+            const NavEdge *edge = &graph->edges[e];
+            int t = edge->to;
+            if (graph->closed[t] == search) continue;
+
+            float cost = graph->cost[s] + edge->cost;
+            if (!graph->spans[t].open) {
+                blocked = fminf(blocked, cost + fabsf(GetSpanCenter(&graph->spans[t]) - goalX));
+                continue;
+            }
+            if (graph->visited[t] == search && cost >= graph->cost[t]) continue;
+            graph->visited[t] = search;
+            graph->cost[t] = cost;
+            graph->cameFrom[t] = e;
+            if (heapCount < graph->heapCapacity)
+                PushHeap(graph, &heapCount, (NavHeapItem){ cost + fabsf(GetSpanCenter(&graph->spans[t]) - goalX), t });
+        }
+    }
+
+    if (!found) {
+        StoreRoute(graph, start, goal, -1, 0, blocked < INFINITY);
+        return -1;
+    }
+
+    // Back from the goal, caching the first edge of every span on the way
+    unsigned long long spans = GetSpanBit(goal);
+    bool detour = blocked < graph->cost[goal];
+    int edge = -1;
+    for (int s = goal; s != start; s = graph->edges[edge].from) {
+        edge = graph->cameFrom[s];
+        spans |= GetSpanBit(graph->edges[edge].from);
+        StoreRoute(graph, graph->edges[edge].from, goal, edge, spans, detour);
+    }
+    return edge;
+}
+
+int FindNavRoute(NavGraph *graph, int start, int goal)
+{
+    if (start < 0 || goal < 0 || start == goal) return -1;
+
+    NavRoute *route = GetCacheSlot(graph, start, goal);
+    if (route->start == start && route->goal == goal && IsRouteValid(graph, route)) {
+        graph->cacheHits++;
+        return route->edge;
+    }
+
+    if (graph->searchesLeft <= 0) return -1;
+    graph->searchesLeft--;
+    return SearchRoute(graph, start, goal);
+}
+
+void BeginNavTick(NavGraph *graph)
+{
+    graph->searchesLeft = NAV_SEARCHES_PER_TICK;
+}
+
+void ClearNavCache(NavGraph *graph)
+{
+    for (int i = 0; i < NAV_CACHE_SIZE; i++) graph->cache[i] = (NavRoute){ .start = -1 };
+}
+
+void SetNavSpanOpen(NavGraph *graph, int span, bool open)
+{
+    if (graph->spans[span].open == open) return;
+
+    // No cached route runs through a closed span, so opening one only
+    // drops the detours
+    graph->spans[span].open = open;
+    graph->version++;
+    if (open) graph->lastOpenedAt = graph->version;
+    else graph->spanBitChangedAt[span & 63] = graph->version;
+}
@@ -0,0 +1,117 @@
+#ifndef NAVIGATION_H
+#define NAVIGATION_H
+
+#include "raylib.h"
+#include "collision.h"
+#include "memory.h"
+
+// Platformer navigation graph, built once when the level loads. Every
+// platform top is cut into walkable spans of at most NAV_SPAN_WIDTH; edges
+// walk to the neighbouring span, jump to spans a jump can reach, or fall off
+// a platform end onto whatever lies below. Jump and fall reach comes from the
+// game's own gravity and jump velocity, so the graph matches the physics.
+// Positions are body centers: an edge is taken from takeoffX.
+#define NAV_SPAN_WIDTH 256.0f
+#define NAV_MAX_DROP 640.0f             // deepest fall or jump down considered
+#define NAV_CACHE_SIZE 1024             // cached routes, a power of two
+#define NAV_SEARCHES_PER_TICK 8         // A* runs allowed per tick, cache hits are free
+
+typedef enum {
+    NAV_WALK,
+    NAV_JUMP,
+    NAV_FALL
+} NavEdgeType;
+
+typedef struct {
+    int from;
+    int to;
+    int type;               // NavEdgeType
+    float takeoffX;
+    float cost;
+} NavEdge;
+
+typedef struct {
+    float x0;               // top face of the platform between x0 and x1
+    float x1;
+    float y;
+    int platform;
+    int edgeFirst;          // outgoing edges [edgeFirst, edgeFirst + edgeCount)
+    int edgeCount;
+    bool open;              // closed spans are routed around
+} NavSpan;
+
+// Route from start to goal: the first edge to take, and the spans on the
+// way (one bit per span index modulo 64) to tell when a change touches it
+typedef struct {
+    int start;              // -1 for an empty slot
+    int goal;
+    int edge;               // -1 when the goal is unreachable
+    unsigned int builtAt;   // graph version when stored
+    unsigned long long spans;
+    bool detour;            // a closed span might have given a shorter route
+} NavRoute;
+
+typedef struct {
+    float priority;         // cost so far plus the estimate to the goal
+    int span;
+} NavHeapItem;
+
+typedef struct {
+    float gravity;          // physics the graph was built for
+    float jumpForce;
+    float airSpeed;         // horizontal speed in the air
+
+    NavSpan *spans;
+    int spanCount;
+    NavEdge *edges;
+    int edgeCount;
+    int *platformSpanFirst;     // spans of platform p start here, platformCount + 1 entries
+
+    // Incremental invalidation: closing a span bumps the version and drops
+    // only the cached routes whose span bits include it, opening one only
+    // the detours
+    unsigned int version;
+    unsigned int spanBitChangedAt[64];
+    unsigned int lastOpenedAt;      // detours may have a better route now
+
+    NavRoute *cache;        // NAV_CACHE_SIZE slots
+    int searchesLeft;
+
+    // A* scratch, stamped so nothing is cleared between searches
+    float *cost;
+    int *cameFrom;          // edge into each span on the best route found
+    int *visited;           // search that set cost and cameFrom
+    int *closed;
+    int search;
+    NavHeapItem *heap;
+    int heapCapacity;
+
+    // Totals since the level loaded
+    long long searches;
+    long long cacheHits;
+} NavGraph;
+
+// Build from one-way platforms and their grid, with jumps taking off at
+// jumpForce (negative, px/s) and moving at airSpeed while in the air.
+// Returns false when out of memory.
+bool BuildNavGraph(NavGraph *graph, Arena *arena, const Rectangle *platforms, int platformCount, SpatialGrid *platformGrid,
+                   float gravity, float jumpForce, float airSpeed);
+
+// Span of a platform under a body center x
+int GetNavSpan(const NavGraph *graph, int platform, float x);
+
+// First edge from start toward goal, or -1 when there is none or the search
+// budget for this tick is spent (ask again next tick). Routes are cached:
+// all spans on a route found by A* share it, so most queries are lookups.
+int FindNavRoute(NavGraph *graph, int start, int goal);
+
+// Reset the per-tick A* budget
+void BeginNavTick(NavGraph *graph);
+void ClearNavCache(NavGraph *graph);
+
+// Open or close a span (e.g. a platform that breaks or a blocked door).
+// Closing drops the cached routes through it, opening the routes found
+// around closed spans; the rest stay valid.
+void SetNavSpanOpen(NavGraph *graph, int span, bool open);
+
+#endif
@@ -0,0 +1,136 @@
+#include "particles.h"
+#include "atlas.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+typedef struct {
+    int count;
+    int sprite;             // first sprite, or PARTICLE_PLAIN
+    int spriteVariants;     // sprites picked at random, starting at sprite
+    Color color;
+    float sizeMin, sizeMax;
+    Vector2 velocityMin, velocityMax;
+    float gravity;
+    float lifeMin, lifeMax;
+} ParticleEffectDesc;
+
+static const ParticleEffectDesc effects[PARTICLE_EFFECT_COUNT] = {
+    [PARTICLE_DUST]       = { 12, PARTICLE_PLAIN, 1, { 214, 196, 168, 220 }, 3.0f, 6.0f,
+                              { -90.0f, -80.0f }, { 90.0f, -10.0f }, 150.0f, 0.25f, 0.5f },
+    [PARTICLE_SPARKS]     = { 24, PARTICLE_PLAIN, 1, { 255, 196, 64, 255 }, 2.0f, 4.0f,
+                              { -260.0f, -320.0f }, { 260.0f, 120.0f }, 900.0f, 0.3f, 0.6f },
+    [PARTICLE_BOX_DEBRIS] = { 8, SPRITE_BOX_PIECE_1, 4, { 255, 255, 255, 255 }, 1.0f, 1.0f,
+                              { -160.0f, -420.0f }, { 160.0f, -120.0f }, 1800.0f, 0.8f, 1.2f },
+};
+
+// xorshift32: cheap, and keeps raylib's random sequence (camera shake) untouched
+static unsigned int rngState = 0x9e3779b9u;
+
+static float RandomRange(float min, float max)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return min + (max - min)*(float)(rngState >> 8)*(1.0f/16777216.0f);
+}
+
+bool InitParticles(Particles *particles, Arena *arena, int capacity)
+{
+    *particles = (Particles){ 0 };
+
+    // Float, int and Color columns are all 4 bytes wide
+    float *block = ArenaAlloc(arena, 10*(size_t)capacity*sizeof(float));
+    if (block == NULL) return false;
+
+    particles->x = block;
+    particles->y = particles->x + capacity;
+    particles->vx = particles->y + capacity;
+    particles->vy = particles->vx + capacity;
+    particles->gravity = particles->vy + capacity;
+    particles->life = particles->gravity + capacity;
+    particles->lifetime = particles->life + capacity;
+    particles->size = particles->lifetime + capacity;
+    particles->sprite = (int *)(particles->size + capacity);
+    particles->color = (Color *)(particles->sprite + capacity);
+    particles->capacity = capacity;
+    return true;
+}
+
+void ClearParticles(Particles *particles)
+{
+    particles->count = 0;
+}
+
+void EmitParticles(Particles *particles, ParticleEffect effect, Vector2 position)
+{
+    const ParticleEffectDesc *desc = &effects[effect];
+
+    for (int n = 0; n < desc->count && particles->count < particles->capacity; n++) {
+        int i = particles->count++;
+        particles->x[i] = position.x;
+        particles->y[i] = position.y;
+        particles->vx[i] = RandomRange(desc->velocityMin.x, desc->velocityMax.x);
+        particles->vy[i] = RandomRange(desc->velocityMin.y, desc->velocityMax.y);
+        particles->gravity[i] = desc->gravity;
+        particles->lifetime[i] = RandomRange(desc->lifeMin, desc->lifeMax);
+        particles->life[i] = particles->lifetime[i];
+        particles->size[i] = RandomRange(desc->sizeMin, desc->sizeMax);
+        particles->sprite[i] = (desc->sprite == PARTICLE_PLAIN) ? PARTICLE_PLAIN :
+                               desc->sprite + (int)RandomRange(0, desc->spriteVariants - 0.001f);
+        particles->color[i] = desc->color;
+    }
+}
+
+// Move the last particle into slot i
+static void MoveParticle(Particles *particles, int i, int last)
+{
+    particles->x[i] = particles->x[last];
+    particles->y[i] = particles->y[last];
+    particles->vx[i] = particles->vx[last];
+    particles->vy[i] = particles->vy[last];
+    particles->gravity[i] = particles->gravity[last];
+    particles->life[i] = particles->life[last];
+    particles->lifetime[i] = particles->lifetime[last];
+    particles->size[i] = particles->size[last];
+    particles->sprite[i] = particles->sprite[last];
+    particles->color[i] = particles->color[last];
+}
+
+void UpdateParticles(Particles *particles, float dt)
+{
+    const int count = particles->count;
+    int i = 0;
+
+#if defined(__SSE2__)
+    const __m128 vdt = _mm_set1_ps(dt);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 vy = _mm_loadu_ps(&particles->vy[i]);
+        vy = _mm_add_ps(vy, _mm_mul_ps(_mm_loadu_ps(&particles->gravity[i]), vdt));
+
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&particles->x[i]), _mm_mul_ps(_mm_loadu_ps(&particles->vx[i]), vdt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&particles->y[i]), _mm_mul_ps(vy, vdt));
+        __m128 life = _mm_sub_ps(_mm_loadu_ps(&particles->life[i]), vdt);
+
+        _mm_storeu_ps(&particles->x[i], x);
+        _mm_storeu_ps(&particles->y[i], y);
+        _mm_storeu_ps(&particles->vy[i], vy);
+        _mm_storeu_ps(&particles->life[i], life);
+    }
+#endif
+
+    for (; i < count; i++) {
+        particles->vy[i] += particles->gravity[i]*dt;
+        particles->x[i] += particles->vx[i]*dt;
+        particles->y[i] += particles->vy[i]*dt;
+        particles->life[i] -= dt;
+    }
+
+    // Swap-remove the expired ones (order does not matter for drawing)
+    for (int k = 0; k < particles->count;) {
+        if (particles->life[k] > 0.0f) { k++; continue; }
+        MoveParticle(particles, k, --particles->count);
+    }
+}
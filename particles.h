@@ -0,0 +1,46 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "raylib.h"
+#include "memory.h"
+
+// Cosmetic particles (dust, sparks, debris), simulated on the render side
+// so they never touch the deterministic game state. Stored as
+// struct-of-arrays like the entities; live particles are packed into
+// [0, count) and a dead one is replaced by the last.
+#define MAX_PARTICLES 131072
+#define PARTICLE_PLAIN -1       // sprite of an untextured square
+
+typedef struct {
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *gravity;
+    float *life;            // seconds left
+    float *lifetime;
+    float *size;            // side of a plain square, scale of a sprite
+    int *sprite;            // SpriteId, or PARTICLE_PLAIN
+    Color *color;
+    int count;
+    int capacity;
+} Particles;
+
+typedef enum {
+    PARTICLE_DUST,          // the player lands
+    PARTICLE_SPARKS,        // the player is hit
+    PARTICLE_BOX_DEBRIS,    // a box breaks
+    PARTICLE_EFFECT_COUNT
+} ParticleEffect;
+
+bool InitParticles(Particles *particles, Arena *arena, int capacity);
+void ClearParticles(Particles *particles);
+
+// Spawn one burst of an effect, dropping what does not fit
+void EmitParticles(Particles *particles, ParticleEffect effect, Vector2 position);
+
+// Integrate position, velocity, gravity and lifetime (four particles per
+// SSE2 instruction), then remove the particles that expired
+void UpdateParticles(Particles *particles, float dt);
+
+#endif
@@ -0,0 +1,258 @@
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #define _POSIX_C_SOURCE 199309L
+    #include <time.h>
+#endif
+
+#include "profile.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const char *profileZoneNames[PROFILE_ZONE_COUNT] = {
+    [PROFILE_FRAME] = "frame",
+    [PROFILE_UPDATE] = "update",
+    [PROFILE_TICK] = "tick",
+    [PROFILE_PLAYER] = "player",
+    [PROFILE_SPIKEHEADS] = "spike heads",
+    [PROFILE_ENEMIES] = "enemies",
+    [PROFILE_PROJECTILES] = "projectiles",
+    [PROFILE_DIAMONDS] = "diamonds",
+    [PROFILE_CAMERA] = "camera",
+    [PROFILE_PARTICLES] = "particles",
+    [PROFILE_DRAW_WORLD] = "draw world",
+    [PROFILE_DRAW_HUD] = "draw hud",
+    [PROFILE_SWAP] = "swap",
+    [PROFILE_LOAD_LEVEL] = "load level",
+    [PROFILE_LOAD_IMAGES] = "load images",
+    [PROFILE_UPLOAD_TEXTURES] = "upload textures",
+    [PROFILE_BAKE_STATIC] = "bake static",
+};
+
+ProfileCounter profileCounters[PROFILE_ZONE_COUNT];
+int profileFrameCount = 0;
+
+// One closed zone of a recording trace
+typedef struct {
+    double start;
+    double duration;
+    int zone;
+    int frame;
+    int thread;
+} TraceEvent;
+
+static __thread int profileThread = PROFILE_THREAD_MAIN;
+static const char *profileThreadNames[PROFILE_THREAD_COUNT] = {
+    [PROFILE_THREAD_MAIN] = "main",
+    [PROFILE_THREAD_SIM] = "simulation",
+    [PROFILE_THREAD_LOADER] = "asset loader",
+};
+
+static struct {
+    pthread_mutex_t lock;       // events come from several threads
+    bool recording;
+    double origin;          // trace timestamps are relative to this
+    TraceEvent *events;
+    int count;
+    int capacity;
+} trace = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// profileCounters belong to the main thread; zones closed on other threads
+// add up here until EndProfileFrame folds them in
+static struct {
+    pthread_mutex_t lock;
+    double total[PROFILE_ZONE_COUNT];
+    long long calls[PROFILE_ZONE_COUNT];
+} pending = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static __thread double zoneStarts[PROFILE_ZONE_COUNT];
+
+#if defined(_WIN32)
+
+double GetProfileTime(void)
+{
+    static double period = 0.0;
+    LARGE_INTEGER counter;
+    if (period == 0.0) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        period = 1.0/(double)frequency.QuadPart;
+    }
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart*period;
+}
+
+#else
+
+double GetProfileTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+#endif
+
+void ResetProfile(void)
+{
+    pthread_mutex_lock(&pending.lock);
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+        profileCounters[i] = (ProfileCounter){ 0 };
+        pending.total[i] = 0.0;
+        pending.calls[i] = 0;
+    }
+    pthread_mutex_unlock(&pending.lock);
+    __atomic_store_n(&profileFrameCount, 0, __ATOMIC_RELEASE);
+}
+
+void BeginProfileZone(ProfileZone zone)
+{
+    zoneStarts[zone] = GetProfileTime();
+}
+
+void EndProfileZone(ProfileZone zone)
+{
+    double start = zoneStarts[zone];
+    double duration = GetProfileTime() - start;
+    if (profileThread == PROFILE_THREAD_MAIN) {
+        profileCounters[zone].total += duration;
+        profileCounters[zone].calls++;
+    } else {
+        pthread_mutex_lock(&pending.lock);
+        pending.total[zone] += duration;
+        pending.calls[zone]++;
+        pthread_mutex_unlock(&pending.lock);
+    }
+
+    if (!__atomic_load_n(&trace.recording, __ATOMIC_ACQUIRE)) return;
+
+    pthread_mutex_lock(&trace.lock);
+    if (trace.recording && trace.count == trace.capacity) {
+        int capacity = (trace.capacity > 0) ? trace.capacity*2 : 4096;
+        TraceEvent *events = realloc(trace.events, capacity*sizeof(TraceEvent));
+        if (events != NULL) {
+            trace.events = events;
+            trace.capacity = capacity;
+        }
+    }
+    // Drop the event rather than the trace when out of memory
+    if (trace.recording && trace.count < trace.capacity)
+        trace.events[trace.count++] = (TraceEvent){ start, duration, zone,
+            __atomic_load_n(&profileFrameCount, __ATOMIC_ACQUIRE), profileThread };
+    pthread_mutex_unlock(&trace.lock);
+}
+
+void SetProfileThread(ProfileThread thread)
+{
+    profileThread = thread;
+}
+
+void StartProfileTrace(void)
+{
+    pthread_mutex_lock(&trace.lock);
+    trace.origin = GetProfileTime();
+    trace.count = 0;
+    __atomic_store_n(&trace.recording, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&trace.lock);
+}
+
+bool IsProfileTracing(void)
+{
+    return __atomic_load_n(&trace.recording, __ATOMIC_ACQUIRE);
+}
+
+bool StopProfileTrace(const char *path)
+{
+    pthread_mutex_lock(&trace.lock);
+    bool wasRecording = trace.recording;
+    __atomic_store_n(&trace.recording, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&trace.lock);
+    if (!wasRecording) return false;
+
+    FILE *out = fopen(path, "w");
+    if (out == NULL) return false;
+
+    // Complete ("X") events in microseconds; spans opened before the trace
+    // started (the frame that started it) are clamped to the origin
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < PROFILE_THREAD_COUNT; i++) {
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                (i > 0) ? ",\n" : "", i + 1, profileThreadNames[i]);
+    }
+    for (int i = 0; i < trace.count; i++) {
+        const TraceEvent *event = &trace.events[i];
+        double start = event->start - trace.origin;
+        double duration = event->duration;
+        if (start < 0.0) { duration += start; start = 0.0; }
+        if (duration < 0.0) continue;
+
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"game\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%d}}",
+                profileZoneNames[event->zone], start*1e6, duration*1e6, event->thread + 1, event->frame);
+    }
+    fprintf(out, "\n]}\n");
+
+    bool ok = (ferror(out) == 0);
+    if (fclose(out) != 0) ok = false;
+
+    free(trace.events);
+    trace.events = NULL;
+    trace.count = 0;
+    trace.capacity = 0;
+    return ok;
+}
+
+void EndProfileFrame(void)
+{
+    pthread_mutex_lock(&pending.lock);
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+        profileCounters[i].total += pending.total[i];
+        profileCounters[i].calls += pending.calls[i];
+        pending.total[i] = 0.0;
+        pending.calls[i] = 0;
+    }
+    pthread_mutex_unlock(&pending.lock);
+
+    int slot = profileFrameCount % PROFILE_HISTORY;
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+        ProfileCounter *counter = &profileCounters[i];
+        counter->history[slot] = (float)(counter->total - counter->frameStart);
+        counter->frameStart = counter->total;
+    }
+    __atomic_store_n(&profileFrameCount, profileFrameCount + 1, __ATOMIC_RELEASE);
+}
+
+float GetProfileHistory(ProfileZone zone, int age)
+{
+    if (age < 0 || age >= profileFrameCount || age >= PROFILE_HISTORY) return 0.0f;
+    return profileCounters[zone].history[(profileFrameCount - 1 - age) % PROFILE_HISTORY];
+}
+
+static int CompareFloats(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+ProfileStats GetProfileStats(ProfileZone zone)
+{
+    ProfileStats stats = { 0 };
+    int count = (profileFrameCount < PROFILE_HISTORY) ? profileFrameCount : PROFILE_HISTORY;
+    if (count == 0) return stats;
+
+    float sorted[PROFILE_HISTORY];
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sorted[i] = profileCounters[zone].history[i];
+        sum += sorted[i];
+    }
+    qsort(sorted, count, sizeof(float), CompareFloats);
+
+    stats.min = sorted[0];
+    stats.avg = (float)(sum/count);
+    stats.p99 = sorted[(count - 1)*99/100];
+    stats.last = GetProfileHistory(zone, 0);
+    return stats;
+}
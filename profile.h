@@ -0,0 +1,98 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+
+// Lightweight timing of the game loop. Each zone accumulates the time
+// spent between its begin/end markers and how often it ran; EndProfileFrame
+// keeps the last PROFILE_HISTORY frames of every zone for rolling stats.
+// While a trace is recording, every closed zone is also logged as a Chrome
+// trace event (open the file in chrome://tracing or ui.perfetto.dev).
+// Zones may run on any thread; counters and stats belong to the main
+// thread, which folds in the other threads' time at EndProfileFrame.
+// Build with -DNO_PROFILE to compile the markers out entirely.
+#define PROFILE_HISTORY 240
+
+typedef enum {
+    PROFILE_FRAME,          // one whole pass of the main loop
+    PROFILE_UPDATE,         // all fixed ticks run this frame
+    PROFILE_TICK,           // one whole UpdateGame call
+    PROFILE_PLAYER,         // movement and platform sweep
+    PROFILE_SPIKEHEADS,
+    PROFILE_ENEMIES,        // AI and movement at every level of detail
+    PROFILE_PROJECTILES,    // cannons, flight, blasts
+    PROFILE_DIAMONDS,
+    PROFILE_CAMERA,
+    PROFILE_PARTICLES,      // cosmetic particle update
+    PROFILE_DRAW_WORLD,
+    PROFILE_DRAW_HUD,
+    PROFILE_SWAP,           // EndDrawing: buffer swap and frame pacing
+    PROFILE_LOAD_LEVEL,
+    PROFILE_LOAD_IMAGES,    // atlas pack read, or sprite decode and packing
+    PROFILE_UPLOAD_TEXTURES,
+    PROFILE_BAKE_STATIC,    // static geometry chunks
+    PROFILE_ZONE_COUNT
+} ProfileZone;
+
+typedef struct {
+    double total;           // seconds
+    long long calls;
+    double frameStart;      // total when the current frame began
+    float history[PROFILE_HISTORY];     // seconds per frame, ring buffer
+} ProfileCounter;
+
+typedef struct {
+    float min;
+    float avg;
+    float p99;
+    float last;
+} ProfileStats;
+
+extern const char *profileZoneNames[PROFILE_ZONE_COUNT];
+extern ProfileCounter profileCounters[PROFILE_ZONE_COUNT];
+extern int profileFrameCount;   // frames recorded, history holds the last PROFILE_HISTORY (main thread writes)
+
+// Monotonic high resolution clock in seconds (usable without a window)
+double GetProfileTime(void);
+void ResetProfile(void);
+
+// Close the current frame: store each zone's time for this frame in its history
+void EndProfileFrame(void);
+
+// Rolling stats of a zone over the recorded history, in seconds
+ProfileStats GetProfileStats(ProfileZone zone);
+
+// Zone time of the frame recorded `age` frames ago (0 = last frame)
+float GetProfileHistory(ProfileZone zone, int age);
+
+void BeginProfileZone(ProfileZone zone);
+void EndProfileZone(ProfileZone zone);
+
+// Threads that show up as separate tracks in a trace
+typedef enum {
+    PROFILE_THREAD_MAIN,
+    PROFILE_THREAD_SIM,
+    PROFILE_THREAD_LOADER,
+    PROFILE_THREAD_COUNT
+} ProfileThread;
+
+// Tag the calling thread's trace events (threads default to main)
+void SetProfileThread(ProfileThread thread);
+
+// Chrome trace recording. Events are buffered in memory and written as
+// JSON when the trace stops; returns false if the file cannot be written.
+#define PROFILE_TRACE_DEFAULT_PATH "trace.json"
+
+void StartProfileTrace(void);
+bool StopProfileTrace(const char *path);
+bool IsProfileTracing(void);
+
+#if defined(NO_PROFILE)
+    #define PROFILE_BEGIN(zone) ((void)0)
+    #define PROFILE_END(zone) ((void)0)
+#else
+    #define PROFILE_BEGIN(zone) BeginProfileZone(zone)
+    #define PROFILE_END(zone) EndProfileZone(zone)
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+#include "projectiles.h"
+
+#include <math.h>
+
+// Cannon balls leave the muzzle at this point of the left-facing sprite
+#define CANNON_MUZZLE_X 20.0f
+#define CANNON_MUZZLE_Y 38.0f
+
+// Lobs fly at about this horizontal speed, within these flight times
+#define THROW_SPEED 400.0f
+#define THROW_MIN_TIME 0.35f
+#define THROW_MAX_TIME 0.9f
+
+#define PROJECTILE_MAX_NEARBY 64
+
+// Sizes in px (the sprites at scale 2), times in seconds
+const ProjectileDesc projectileDescs[PROJECTILE_KIND_COUNT] = {
+    //                         width height gravity life  blast  breaks
+    [PROJECTILE_CANNON_BALL] = { 24, 24,    0.0f,   4.0f,  0.0f, true },
+    [PROJECTILE_BOX]         = { 44, 32,    1.0f,   4.0f,  0.0f, true },
+    [PROJECTILE_BOMB]        = { 28, 28,    1.0f,   1.6f, 96.0f, false },
+    [PROJECTILE_BLAST]       = {  0,  0,    0.0f,   0.6f,  0.0f, false },
+};
+
+bool InitProjectiles(Pool *projectiles, Arena *arena)
+{
+    return InitPool(projectiles, arena, sizeof(Projectile), PROJECTILE_CAPACITY);
+}
+
+void SpawnProjectile(Pool *projectiles, ProjectileKind kind, Vector2 center, Vector2 velocity)
+{
+    Projectile *p = PoolAlloc(projectiles);
+    if (p == NULL) return;
+
+    const ProjectileDesc *desc = &projectileDescs[kind];
+    float x = center.x - desc->width/2, y = center.y - desc->height/2;
+    *p = (Projectile){ x, y, x, y, velocity.x, velocity.y, desc->lifetime, kind, false };
+}
+
+Vector2 AimProjectile(Vector2 from, Vector2 to, float gravity)
+{
+    float t = fminf(fmaxf(fabsf(to.x - from.x)/THROW_SPEED, THROW_MIN_TIME), THROW_MAX_TIME);
+    return (Vector2){ (to.x - from.x)/t, (to.y - from.y)/t - 0.5f*gravity*t };
+}
+
+void FireCannons(const LevelCannon *cannons, float *timers, int begin, int end, float dt, Pool *projectiles)
+{
+    for (int i = begin; i < end; i++) {
+        timers[i] += dt;
+        if (timers[i] < cannons[i].period) continue;
+        timers[i] -= cannons[i].period;
+
+        const LevelCannon *cannon = &cannons[i];
+        float muzzleX = (cannon->facing < 0) ? cannon->x + CANNON_MUZZLE_X : cannon->x + CANNON_WIDTH - CANNON_MUZZLE_X;
+        SpawnProjectile(projectiles, PROJECTILE_CANNON_BALL, (Vector2){ muzzleX, cannon->y + CANNON_MUZZLE_Y },
+                        (Vector2){ cannon->facing*CANNON_BALL_SPEED, 0.0f });
+    }
+}
+
+// Swept landing test on the platform tops under a falling projectile.
+// Returns the platform it lands on, or -1.
+static int Land(Projectile *p, const ProjectileDesc *desc, ProjectileUpdate *update, float dx, float dy)
+{
+    Rectangle body = { p->x, p->y, desc->width, desc->height };
+    Rectangle swept = { (dx < 0) ? body.x + dx : body.x, body.y, body.width + fabsf(dx), body.height + dy };
+
+    int nearby[PROJECTILE_MAX_NEARBY];
+    int nearbyCount = QuerySpatialGrid(update->platformGrid, swept, nearby, PROJECTILE_MAX_NEARBY);
+
+    float landingTime = 1.0f;
+    int landing = -1;
+    for (int n = 0; n < nearbyCount; n++) {
+        float toi;
+        Vector2 normal;
+        if (SweepRects(body, (Vector2){ dx, dy }, update->platforms[nearby[n]], &toi, &normal) &&
+            normal.y < 0 && toi <= landingTime) {
+            landingTime = toi;
+            landing = nearby[n];
+        }
+    }
+    return landing;
+}
+
+static bool AddImpact(ProjectileUpdate *update, int kind, Vector2 position)
+{
+    if (update->impactCount >= PROJECTILE_MAX_IMPACTS) return false;
+    update->impacts[update->impactCount++] = (ProjectileImpact){ kind, position };
+    return true;
+}
+
+void UpdateProjectiles(Pool *projectiles, ProjectileUpdate *update)
+{
+    const float dt = update->dt;
+    const Rectangle player = update->player;
+
+    for (int i = 0; i < projectiles->highWater; i++) {
+        Projectile *p = GetPoolItem(projectiles, i);
+        if (p == NULL) continue;
+
+        const ProjectileDesc *desc = &projectileDescs[p->kind];
+        p->prevX = p->x;
+        p->prevY = p->y;
+        p->life -= dt;
+
+        if (p->kind == PROJECTILE_BLAST) {
+            if (p->life <= 0.0f) PoolFree(projectiles, p);
+            continue;
+        }
+
+        int landing = -1;
+        if (!p->resting) {
+            p->vy += desc->gravity*update->gravity*dt;
+            float dx = p->vx*dt, dy = p->vy*dt;
+            if (dy > 0.0f) landing = Land(p, desc, update, dx, dy);
+
+            p->x += dx;
+            if (landing >= 0) p->y = update->platforms[landing].y - desc->height;
+            else p->y += dy;
+        }
+
+        Rectangle body = { p->x, p->y, desc->width, desc->height };
+        Vector2 center = { p->x + desc->width/2, p->y + desc->height/2 };
+        bool touches = OverlapRects(player, body);
+        if (touches) update->hit = true;
+
+        if (desc->blastRadius > 0.0f && (touches || p->life <= 0.0f)) {
+            // Goes off in place; waits a tick when there is no room to report it
+            if (!AddImpact(update, p->kind, center)) continue;
+            *p = (Projectile){ center.x, center.y, center.x, center.y, 0.0f, 0.0f,
+                               projectileDescs[PROJECTILE_BLAST].lifetime, PROJECTILE_BLAST, false };
+        } else if (touches || (landing >= 0 && desc->breaks)) {
+            AddImpact(update, p->kind, center);
+            PoolFree(projectiles, p);
+        } else if (p->life <= 0.0f || p->x + desc->width < 0.0f || p->x > update->worldWidth || p->y > update->worldHeight) {
+            PoolFree(projectiles, p);
+        } else if (landing >= 0) {
+            p->vx = 0.0f;
+            p->vy = 0.0f;
+            p->resting = true;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef PROJECTILES_H
+#define PROJECTILES_H
+
+#include "raylib.h"
+#include "collision.h"
+#include "level.h"
+#include "memory.h"
+
+// Cannon balls, thrown boxes and bombs. Short-lived, so they come from a
+// Pool that is rebuilt every run instead of level tables. Every kind flies
+// the same ballistic step; what it does when it lands, expires or touches
+// the player comes from its ProjectileDesc.
+#define PROJECTILE_CAPACITY 8192
+
+typedef enum {
+    PROJECTILE_CANNON_BALL,
+    PROJECTILE_BOX,
+    PROJECTILE_BOMB,
+    PROJECTILE_BLAST,           // a bomb that went off, drawn until it fades
+    PROJECTILE_KIND_COUNT
+} ProjectileKind;
+
+typedef struct {
+    float width;                // hitbox
+    float height;
+    float gravity;              // share of the world gravity
+    float lifetime;             // seconds until it expires, a bomb's fuse
+    float blastRadius;          // explodes on expiring or touching the player, 0 for none
+    bool breaks;                // breaks on landing, otherwise comes to rest
+} ProjectileDesc;
+
+extern const ProjectileDesc projectileDescs[PROJECTILE_KIND_COUNT];
+
+typedef struct {
+    float x;                    // hitbox top-left
+    float y;
+    float prevX;                // position at the start of the last tick
+    float prevY;
+    float vx;
+    float vy;
+    float life;                 // seconds left
+    int kind;                   // ProjectileKind
+    bool resting;               // on a platform, waiting for its fuse
+} Projectile;
+
+// Cannons of the active chunks fire on their own period
+#define CANNON_WIDTH 88             // Sprites/10-Cannon frames at scale 2
+#define CANNON_HEIGHT 56
+#define CANNON_BALL_SPEED 360.0f
+#define CANNON_SHOOT_TIME 0.4f      // recoil animation after a shot
+
+// Something that happened to a projectile this tick, for the game to react
+// to (blasts, effects)
+#define PROJECTILE_MAX_IMPACTS 256
+
+typedef struct {
+    int kind;                   // ProjectileKind of what hit
+    Vector2 position;           // hitbox center
+} ProjectileImpact;
+
+typedef struct {
+    const Rectangle *platforms;     // one-way, only their tops stop a projectile
+    SpatialGrid *platformGrid;
+    float worldWidth;               // projectiles leaving the world are dropped
+    float worldHeight;
+    float gravity;
+    Rectangle player;
+    float dt;
+
+    bool hit;                       // a projectile touched the player
+    int impactCount;
+    ProjectileImpact impacts[PROJECTILE_MAX_IMPACTS];
+} ProjectileUpdate;
+
+bool InitProjectiles(Pool *projectiles, Arena *arena);
+
+// Launch one from a hitbox center, dropped when the pool is full
+void SpawnProjectile(Pool *projectiles, ProjectileKind kind, Vector2 center, Vector2 velocity);
+
+// Velocity that lobs a projectile from one point to another, flying longer
+// the further the target is
+Vector2 AimProjectile(Vector2 from, Vector2 to, float gravity);
+
+// Count the cannons in [begin, end) up by dt and fire those whose period
+// ran out. timers[i] is the time since cannon i last fired.
+void FireCannons(const LevelCannon *cannons, float *timers, int begin, int end, float dt, Pool *projectiles);
+
+// Move every projectile one tick: platforms are found through the grid,
+// and only while falling, since nothing else can land on a one-way top.
+// Not thread-safe: the grid query uses its stamps.
+void UpdateProjectiles(Pool *projectiles, ProjectileUpdate *update);
+
+#endif
@@ -0,0 +1,740 @@
+#include "render.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define MAX_VISIBLE 1024
+#define CULL_CELL_SIZE 256.0f
+#define ASSET_RELOAD_BUDGET 0.002   // seconds of texture upload per frame while repacking
+#define ENEMY_FRAME_TIME 0.1f
+
+// Profiler overlay layout
+#define OVERLAY_X 600
+#define OVERLAY_Y 10
+#define OVERLAY_WIDTH 390
+#define OVERLAY_GRAPH_HEIGHT 60
+#define OVERLAY_GRAPH_MAX_MS 33.3f
+
+// Sprites of each enemy kind. action is the throw, or peeking out of the
+// box while hidden. The sheets face left.
+typedef struct {
+    SpriteId idle;
+    SpriteId run;
+    SpriteId jump;          // rising, only kinds that jump have their own
+    SpriteId fall;
+    SpriteId action;
+    int frameWidth;         // in the sheet, before the atlas scale
+} EnemySprites;
+
+static const EnemySprites enemySprites[ENEMY_KIND_COUNT] = {
+    [ENEMY_KING_PIG]   = { SPRITE_KING_PIG_IDLE, SPRITE_KING_PIG_RUN, SPRITE_KING_PIG_JUMP, SPRITE_KING_PIG_FALL, SPRITE_KING_PIG_IDLE, 38 },
+    [ENEMY_PIG]        = { SPRITE_PIG_IDLE, SPRITE_PIG_RUN, SPRITE_PIG_JUMP, SPRITE_PIG_FALL, SPRITE_PIG_IDLE, 34 },
+    [ENEMY_BOX_PIG]    = { SPRITE_BOX_PIG_IDLE, SPRITE_BOX_PIG_RUN, SPRITE_BOX_PIG_IDLE, SPRITE_BOX_PIG_IDLE, SPRITE_BOX_PIG_THROW, 26 },
+    [ENEMY_BOMB_PIG]   = { SPRITE_BOMB_PIG_IDLE, SPRITE_BOMB_PIG_RUN, SPRITE_BOMB_PIG_IDLE, SPRITE_BOMB_PIG_IDLE, SPRITE_BOMB_PIG_THROW, 26 },
+    [ENEMY_HIDING_PIG] = { SPRITE_HIDING_PIG_IDLE, SPRITE_HIDING_PIG_HOP, SPRITE_HIDING_PIG_HOP, SPRITE_HIDING_PIG_FALL, SPRITE_HIDING_PIG_LOOK, 26 },
+};
+
+// Projectile sprites: frames of frameWidth (in the sheet, before the atlas
+// scale), drawn offset from the hitbox top-left. A blast's position is
+// its center.
+typedef struct {
+    SpriteId sprite;
+    int frameWidth;
+    Vector2 offset;
+} ProjectileSprite;
+
+static const ProjectileSprite projectileSprites[PROJECTILE_KIND_COUNT] = {
+    [PROJECTILE_CANNON_BALL] = { SPRITE_CANNON_BALL, 44, { 46, 26 } },
+    [PROJECTILE_BOX]         = { SPRITE_BOX, 22, { 0, 0 } },
+    [PROJECTILE_BOMB]        = { SPRITE_BOMB_ON, 52, { 42, 50 } },
+    [PROJECTILE_BLAST]       = { SPRITE_BOMB_BLAST, 52, { 52, 56 } },
+};
+
+// Draw a whole atlas sprite, or a sub-rectangle (frame) of it
+static void DrawSprite(const Atlas *atlas, SpriteId id, float x, float y)
+{
+    DrawTextureRec(atlas->texture, atlas->regions[id], (Vector2){ x, y }, WHITE);
+}
+
+static void DrawSpriteFrame(const Atlas *atlas, SpriteId id, Rectangle frame, Vector2 position)
+{
+    frame.x += atlas->regions[id].x;
+    frame.y += atlas->regions[id].y;
+    DrawTextureRec(atlas->texture, frame, position, WHITE);
+}
+
+// Tile a sprite over [x0, x1) x [y0, y1), only where the tiles meet the view
+static void DrawSpriteTiled(const Atlas *atlas, SpriteId id, Rectangle view, float x0, float y0, float x1, float y1)
+{
+    float w = atlas->regions[id].width;
+    float h = atlas->regions[id].height;
+
+    float startX = x0 + floorf(fmaxf(view.x - x0, 0)/w)*w;
+    float startY = y0 + floorf(fmaxf(view.y - y0, 0)/h)*h;
+    float endX = fminf(x1, view.x + view.width);
+    float endY = fminf(y1, view.y + view.height);
+
+    for (float x = startX; x < endX; x += w) {
+        for (float y = startY; y < endY; y += h) DrawSprite(atlas, id, x, y);
+    }
+}
+
+static Rectangle GetInterpolatedPlayer(const GameSnapshot *snapshot, float alpha)
+{
+    Rectangle player = snapshot->player;
+    player.x = Lerp(snapshot->prevPlayer.x, snapshot->player.x, alpha);
+    player.y = Lerp(snapshot->prevPlayer.y, snapshot->player.y, alpha);
+    return player;
+}
+
+// Tile layer cells inside area, each a TILE_SIZE square of its tileset
+static void DrawTileLayer(const Atlas *atlas, const Level *level, TileLayer layer, SpriteId tileset, Rectangle area)
+{
+    Rectangle region = atlas->regions[tileset];
+    int tilesetCols = (int)region.width/TILE_SIZE;
+
+    int col0 = (int)floorf(area.x/TILE_SIZE), row0 = (int)floorf(area.y/TILE_SIZE);
+    int col1 = (int)floorf((area.x + area.width)/TILE_SIZE), row1 = (int)floorf((area.y + area.height)/TILE_SIZE);
+    for (int col = col0; col <= col1; col++) {
+        for (int row = row0; row <= row1; row++) {
+            int tile = GetLevelTile(level, layer, col, row) - 1;
+            if (tile < 0) continue;
+
+            Rectangle source = { region.x + (tile%tilesetCols)*TILE_SIZE, region.y + (tile/tilesetCols)*TILE_SIZE, TILE_SIZE, TILE_SIZE };
+            DrawTextureRec(atlas->texture, source, (Vector2){ col*TILE_SIZE, row*TILE_SIZE }, WHITE);
+        }
+    }
+}
+
+// Background, tiles, platforms and ground inside area, in world coordinates
+static void DrawStaticGeometry(Renderer *renderer, Rectangle area)
+{
+    const Atlas *atlas = &renderer->atlas;
+    const Level *level = renderer->level;
+    const LevelHeader *header = level->header;
+    int visible[MAX_VISIBLE];
+
+    // Draw tiled background
+    DrawSpriteTiled(atlas, SPRITE_BACKGROUND, area, 0, 0, header->worldWidth, header->worldHeight);
+
+    DrawTileLayer(atlas, level, TILE_LAYER_DECORATIONS, SPRITE_DECORATIONS, area);
+    DrawTileLayer(atlas, level, TILE_LAYER_TERRAIN, SPRITE_TERRAIN, area);
+
+    // Draw platforms (terrain and ground collision is drawn by its own layer)
+    int visibleCount = QuerySpatialGrid(&renderer->platformGrid, area, visible, MAX_VISIBLE);
+    for (int n = 0; n < visibleCount; n++) {
+        if (level->platformKinds[visible[n]] != PLATFORM_SPRITE) continue;
+        Rectangle platform = level->platforms[visible[n]];
+        DrawSprite(atlas, SPRITE_PLATFORM, platform.x, platform.y);
+        // Draw platform hitboxes
+        //DrawRectangleLinesEx(platform, 2, GREEN);
+    }
+
+    // Draw ground along bottom
+    DrawSpriteTiled(atlas, SPRITE_GROUND, area, 0, header->groundY, header->worldWidth, header->groundY + 1);
+}
+
+static Rectangle GetChunkArea(int col, int row)
+{
+    return (Rectangle){ col*STATIC_CHUNK_SIZE, row*STATIC_CHUNK_SIZE, STATIC_CHUNK_SIZE, STATIC_CHUNK_SIZE };
+}
+
+static StaticChunk *FindStaticChunk(Renderer *renderer, int col, int row)
+{
+    for (int i = 0; i < STATIC_CHUNK_CACHE; i++) {
+        if (renderer->chunks[i].col == col && renderer->chunks[i].row == row) return &renderer->chunks[i];
+    }
+    return NULL;
+}
+
+// Bake a chunk into the empty or least recently used slot. Slots needed this
+// frame are never evicted; returns NULL when all of them are.
+static StaticChunk *BakeStaticChunk(Renderer *renderer, int col, int row)
+{
+    StaticChunk *slot = NULL;
+    for (int i = 0; i < STATIC_CHUNK_CACHE; i++) {
+        StaticChunk *chunk = &renderer->chunks[i];
+        if (chunk->lastUsed == renderer->chunkFrame && chunk->col >= 0) continue;
+        if (slot == NULL || chunk->col < 0 || (slot->col >= 0 && chunk->lastUsed < slot->lastUsed)) slot = chunk;
+    }
+    if (slot == NULL) return NULL;
+
+    PROFILE_BEGIN(PROFILE_BAKE_STATIC);
+    if (slot->texture.id == 0) slot->texture = LoadRenderTexture(STATIC_CHUNK_SIZE, STATIC_CHUNK_SIZE);
+
+    Rectangle area = GetChunkArea(col, row);
+    Camera2D chunkCamera = { .target = { area.x, area.y }, .zoom = 1.0f };
+
+    BeginTextureMode(slot->texture);
+        ClearBackground(BLANK);
+        BeginMode2D(chunkCamera);
+            DrawStaticGeometry(renderer, area);
+        EndMode2D();
+    EndTextureMode();
+
+    slot->col = col;
+    slot->row = row;
+    slot->lastUsed = renderer->chunkFrame;
+    PROFILE_END(PROFILE_BAKE_STATIC);
+    return slot;
+}
+
+void InvalidateStaticLayer(Renderer *renderer)
+{
+    for (int i = 0; i < STATIC_CHUNK_CACHE; i++) {
+        renderer->chunks[i].col = -1;
+        renderer->chunks[i].row = -1;
+    }
+}
+
+// Range of chunks overlapping a world rectangle, clamped to the world
+static void GetChunkRange(const Renderer *renderer, Rectangle area, int *col0, int *row0, int *col1, int *row1)
+{
+    *col0 = (int)floorf(area.x/STATIC_CHUNK_SIZE);
+    *row0 = (int)floorf(area.y/STATIC_CHUNK_SIZE);
+    *col1 = (int)floorf((area.x + area.width)/STATIC_CHUNK_SIZE);
+    *row1 = (int)floorf((area.y + area.height)/STATIC_CHUNK_SIZE);
+    if (*col0 < 0) *col0 = 0;
+    if (*row0 < 0) *row0 = 0;
+    if (*col1 >= renderer->chunkCols) *col1 = renderer->chunkCols - 1;
+    if (*row1 >= renderer->chunkRows) *row1 = renderer->chunkRows - 1;
+}
+
+void UpdateStaticLayer(Renderer *renderer)
+{
+    renderer->chunkFrame++;
+
+    int col0, row0, col1, row1;
+    GetChunkRange(renderer, renderer->view, &col0, &row0, &col1, &row1);
+
+    // Everything in view must be baked before drawing
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            StaticChunk *chunk = FindStaticChunk(renderer, col, row);
+            if (chunk != NULL) chunk->lastUsed = renderer->chunkFrame;
+            else BakeStaticChunk(renderer, col, row);
+        }
+    }
+
+    // Spread the next column's bakes over the frames before it scrolls in
+    float dx = renderer->camera.target.x - renderer->lastCameraX;
+    renderer->lastCameraX = renderer->camera.target.x;
+    int ahead = (dx > 0) ? col1 + 1 : (dx < 0) ? col0 - 1 : -1;
+    if (ahead < 0 || ahead >= renderer->chunkCols) return;
+
+    for (int row = row0; row <= row1; row++) {
+        if (FindStaticChunk(renderer, ahead, row) == NULL) {
+            BakeStaticChunk(renderer, ahead, row);
+            break;
+        }
+    }
+}
+
+// Animation frame sizes, derived from the atlas regions
+static void SetupSpriteFrames(Renderer *renderer)
+{
+    const Rectangle *regions = renderer->atlas.regions;
+
+    renderer->frameWidth = 78 * 2;
+    renderer->frameHeight = regions[SPRITE_KING_IDLE].height;
+
+    renderer->idleFrameCount = regions[SPRITE_KING_IDLE].width / renderer->frameWidth;
+    renderer->runFrameCount  = regions[SPRITE_KING_RUN].width  / renderer->frameWidth;
+    renderer->jumpFrameCount = regions[SPRITE_KING_JUMP].width / renderer->frameWidth;
+    renderer->fallFrameCount = regions[SPRITE_KING_FALL].width / renderer->frameWidth;
+    renderer->hitFrameCount  = regions[SPRITE_KING_HIT].width  / renderer->frameWidth;
+
+    renderer->diamondFrameWidth = 18 * 2;
+    renderer->diamondFrameHeight = regions[SPRITE_DIAMOND].height;
+}
+
+static bool FailInitRenderer(Renderer *renderer, Atlas atlas)
+{
+    FreeArena(&renderer->arena);
+    UnloadAtlas(atlas);
+    return false;
+}
+
+bool InitRenderer(Renderer *renderer, Game *game, Atlas atlas)
+{
+    *renderer = (Renderer){ 0 };
+    renderer->level = game->level;
+    renderer->worldWidth = game->worldWidth;
+    renderer->worldHeight = game->worldHeight;
+
+    // Platforms and diamonds never move, cull them through grids of their own
+    InitArena(&renderer->arena, ARENA_BLOCK_SIZE);
+    const Level *level = renderer->level;
+    if (!BuildSpatialGrid(&renderer->platformGrid, &renderer->arena, level->platforms, level->header->platformCount, CULL_CELL_SIZE))
+        return FailInitRenderer(renderer, atlas);
+    const Diamonds *diamonds = &game->diamonds;
+    renderer->diamondWidth = diamonds->width;
+    renderer->diamondHeight = diamonds->height;
+    Rectangle *diamondRects = malloc((diamonds->count + 1)*sizeof(Rectangle));
+    if (diamondRects == NULL) return FailInitRenderer(renderer, atlas);
+    for (int i = 0; i < diamonds->count; i++)
+        diamondRects[i] = (Rectangle){ diamonds->x[i], diamonds->y[i], diamonds->width, diamonds->height };
+    bool built = BuildSpatialGrid(&renderer->diamondGrid, &renderer->arena, diamondRects, diamonds->count, CULL_CELL_SIZE);
+    free(diamondRects);
+    if (!built) return FailInitRenderer(renderer, atlas);
+
+    if (!InitParticles(&renderer->particles, &renderer->arena, MAX_PARTICLES)) return FailInitRenderer(renderer, atlas);
+    renderer->eventsSeen = game->eventCount;
+
+    // All sprites live in one packed texture
+    renderer->atlas = atlas;
+    SetupSpriteFrames(renderer);
+    InitAtlasReloader(&renderer->reloader);
+
+    // Camera
+    Camera2D *camera = &renderer->camera;
+    camera->target = (Vector2){ game->player.x + game->player.width/2, game->player.y + game->player.height/2 };
+    camera->offset = (Vector2){ SCREEN_WIDTH/2.0f, SCREEN_HEIGHT/2.0f };
+    camera->rotation = 0.0f;
+    camera->zoom = 1.0f;
+
+    renderer->cameraDefaultOffset = camera->offset;
+
+    renderer->chunkCols = ((int)renderer->worldWidth + STATIC_CHUNK_SIZE - 1)/STATIC_CHUNK_SIZE;
+    renderer->chunkRows = ((int)renderer->worldHeight + STATIC_CHUNK_SIZE - 1)/STATIC_CHUNK_SIZE;
+    renderer->lastCameraX = camera->target.x;
+    InvalidateStaticLayer(renderer);
+    return true;
+}
+
+void UnloadRenderer(Renderer *renderer)
+{
+    if (renderer->repacking) CancelAtlasLoad(&renderer->repack);
+    UnloadAtlasReloader(&renderer->reloader);
+    for (int i = 0; i < STATIC_CHUNK_CACHE; i++) {
+        if (renderer->chunks[i].texture.id > 0) UnloadRenderTexture(renderer->chunks[i].texture);
+    }
+    FreeArena(&renderer->arena);
+    UnloadAtlas(renderer->atlas);
+}
+
+void UpdateAssetReload(Renderer *renderer)
+{
+    bool patched[SPRITE_COUNT], resized[SPRITE_COUNT];
+    UpdateAtlasReloader(&renderer->reloader, &renderer->atlas, patched, resized);
+
+    // The static chunks hold baked copies of these sprites
+    bool rebake = patched[SPRITE_BACKGROUND] || patched[SPRITE_GROUND] || patched[SPRITE_PLATFORM] ||
+                  patched[SPRITE_TERRAIN] || patched[SPRITE_DECORATIONS];
+
+    // A sprite that changed size needs a new layout: repack the whole atlas
+    // in the background and swap it in once uploaded
+    bool repack = false;
+    for (int i = 0; i < SPRITE_COUNT; i++) repack = repack || resized[i];
+    if (repack && !renderer->repacking) {
+        TraceLog(LOG_INFO, "ATLAS: Sprite size changed, repacking");
+        StartAtlasLoad(&renderer->repack);
+        renderer->repacking = true;
+    }
+
+    if (renderer->repacking && UpdateAtlasLoad(&renderer->repack, ASSET_RELOAD_BUDGET)) {
+        renderer->repacking = false;
+        if (renderer->repack.atlas.texture.id > 0) {
+            UnloadAtlas(renderer->atlas);
+            renderer->atlas = renderer->repack.atlas;
+            SetupSpriteFrames(renderer);
+            rebake = true;
+        }
+    }
+
+    if (rebake) InvalidateStaticLayer(renderer);
+}
+
+void UpdateRenderCamera(Renderer *renderer, const GameSnapshot *snapshot, float alpha)
+{
+    Camera2D *camera = &renderer->camera;
+    Rectangle player = GetInterpolatedPlayer(snapshot, alpha);
+
+    // Camera bounds and follow
+    float targetX = player.x + player.width/2;
+    float targetY = player.y + player.height/2;
+    if (targetX < SCREEN_WIDTH/2) targetX = SCREEN_WIDTH/2;
+    if (targetX > renderer->worldWidth - SCREEN_WIDTH/2) targetX = renderer->worldWidth - SCREEN_WIDTH/2;
+    if (targetY < SCREEN_HEIGHT/2) targetY = SCREEN_HEIGHT/2;
+    if (targetY > renderer->worldHeight - SCREEN_HEIGHT/2) targetY = renderer->worldHeight - SCREEN_HEIGHT/2;
+    camera->target = (Vector2){ targetX, targetY };
+
+    // Camera shake application
+    if (snapshot->shakeTimer > 0.0f) {
+        camera->offset.x = renderer->cameraDefaultOffset.x + (float)(GetRandomValue(-SHAKE_MAGNITUDE, SHAKE_MAGNITUDE));
+        camera->offset.y = renderer->cameraDefaultOffset.y + (float)(GetRandomValue(-SHAKE_MAGNITUDE, SHAKE_MAGNITUDE));
+    } else {
+        camera->offset = renderer->cameraDefaultOffset;
+    }
+
+    // Visible world rectangle
+    renderer->view = (Rectangle){
+        camera->target.x - camera->offset.x/camera->zoom, camera->target.y - camera->offset.y/camera->zoom,
+        SCREEN_WIDTH/camera->zoom, SCREEN_HEIGHT/camera->zoom
+    };
+}
+
+void UpdateParticleEffects(Renderer *renderer, const GameSnapshot *snapshot, float dt)
+{
+    // Events older than the ring were overwritten; skip them
+    unsigned int first = renderer->eventsSeen;
+    if (snapshot->eventCount - first > GAME_EVENT_CAPACITY) first = snapshot->eventCount - GAME_EVENT_CAPACITY;
+
+    for (unsigned int e = first; e != snapshot->eventCount; e++) {
+        const GameEvent *event = &snapshot->events[e%GAME_EVENT_CAPACITY];
+        switch (event->type) {
+            case GAME_EVENT_LAND: EmitParticles(&renderer->particles, PARTICLE_DUST, event->position); break;
+            case GAME_EVENT_HIT:  EmitParticles(&renderer->particles, PARTICLE_SPARKS, event->position); break;
+            case GAME_EVENT_THROW: EmitParticles(&renderer->particles, PARTICLE_DUST, event->position); break;
+            case GAME_EVENT_BREAK: EmitParticles(&renderer->particles, PARTICLE_BOX_DEBRIS, event->position); break;
+            case GAME_EVENT_IMPACT: EmitParticles(&renderer->particles, PARTICLE_DUST, event->position); break;
+            case GAME_EVENT_EXPLODE: EmitParticles(&renderer->particles, PARTICLE_SPARKS, event->position); break;
+        }
+    }
+    renderer->eventsSeen = snapshot->eventCount;
+
+    UpdateParticles(&renderer->particles, dt);
+}
+
+// One quad per particle straight into the rlgl batch. Sprite particles
+// share the atlas with the rest of the world; plain squares use the default
+// white texture in a second pass. Returns the number of particles drawn.
+static int DrawParticles(const Particles *particles, const Atlas *atlas, Rectangle view, bool plain)
+{
+    const float texWidth = atlas->texture.width, texHeight = atlas->texture.height;
+    int drawn = 0;
+
+    rlSetTexture(plain ? rlGetTextureIdDefault() : atlas->texture.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+
+    for (int i = 0; i < particles->count; i++) {
+        int sprite = particles->sprite[i];
+        if ((sprite == PARTICLE_PLAIN) != plain) continue;
+
+        Rectangle source = plain ? (Rectangle){ 0, 0, 1, 1 } : atlas->regions[sprite];
+        float width = plain ? particles->size[i] : source.width*particles->size[i];
+        float height = plain ? particles->size[i] : source.height*particles->size[i];
+        float x = particles->x[i] - width/2, y = particles->y[i] - height/2;
+        if (x > view.x + view.width || y > view.y + view.height || x + width < view.x || y + height < view.y) continue;
+
+        // Fade out over the lifetime
+        Color color = particles->color[i];
+        color.a = (unsigned char)(color.a*particles->life[i]/particles->lifetime[i]);
+
+        float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+        if (!plain) {
+            u0 = source.x/texWidth;
+            v0 = source.y/texHeight;
+            u1 = (source.x + source.width)/texWidth;
+            v1 = (source.y + source.height)/texHeight;
+        }
+
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        rlTexCoord2f(u0, v0); rlVertex2f(x, y);
+        rlTexCoord2f(u0, v1); rlVertex2f(x, y + height);
+        rlTexCoord2f(u1, v1); rlVertex2f(x + width, y + height);
+        rlTexCoord2f(u1, v0); rlVertex2f(x + width, y);
+        drawn++;
+    }
+
+    rlEnd();
+    rlSetTexture(0);
+    return drawn;
+}
+
+// Active enemies from the snapshot, their frames bottom-centered on the hitbox
+static void DrawEnemies(Renderer *renderer, const GameSnapshot *snapshot, float alpha)
+{
+    const Atlas *atlas = &renderer->atlas;
+    const Level *level = renderer->level;
+
+    for (int n = 0; n < snapshot->enemyCount; n++) {
+        int kind = level->enemies[snapshot->enemyFirst + n].kind;
+        const EnemyDesc *desc = &enemyDescs[kind];
+        const EnemySprites *sprites = &enemySprites[kind];
+        float x = Lerp(snapshot->enemyPrevX[n], snapshot->enemyX[n], alpha);
+        float y = Lerp(snapshot->enemyPrevY[n], snapshot->enemyY[n], alpha);
+        float timer = snapshot->enemyTimer[n];
+
+        SpriteId sprite = sprites->idle;
+        switch (snapshot->enemyState[n]) {
+            case ENEMY_PATROL:
+            case ENEMY_CHASE: sprite = (snapshot->enemyX[n] != snapshot->enemyPrevX[n]) ? sprites->run : sprites->idle; break;
+            case ENEMY_THROW:
+            case ENEMY_HIDE:  sprite = sprites->action; break;
+            case ENEMY_FALL:  sprite = (snapshot->enemyY[n] < snapshot->enemyPrevY[n]) ? sprites->jump : sprites->fall; break;
+        }
+
+        Rectangle region = atlas->regions[sprite];
+        float frameWidth = sprites->frameWidth*spriteSources[sprite].scale;
+        int frameCount = (int)(region.width/frameWidth);
+        if (frameCount < 1) frameCount = 1;
+
+        // A throw plays once over the wind-up, everything else loops
+        int frame = (int)(timer/ENEMY_FRAME_TIME)%frameCount;
+        if (snapshot->enemyState[n] == ENEMY_THROW && desc->throwTime > 0.0f)
+            frame = (int)fminf(timer/desc->throwTime*frameCount, frameCount - 1);
+
+        Vector2 position = { x + desc->width/2 - frameWidth/2, y + desc->height - region.height };
+        if (!CheckCollisionRecs((Rectangle){ position.x, position.y, frameWidth, region.height }, renderer->view)) continue;
+
+        Rectangle source = { frame*frameWidth, 0, (snapshot->enemyFacing[n] > 0) ? -frameWidth : frameWidth, region.height };
+        DrawSpriteFrame(atlas, sprite, source, position);
+        renderer->spriteCount++;
+    }
+}
+
+// Cannons recoil for CANNON_SHOOT_TIME after every shot. The sheets face left.
+static void DrawCannons(Renderer *renderer, const GameSnapshot *snapshot)
+{
+    const Atlas *atlas = &renderer->atlas;
+    const Level *level = renderer->level;
+
+    for (int n = 0; n < snapshot->cannonCount; n++) {
+        const LevelCannon *cannon = &level->cannons[snapshot->cannonFirst + n];
+        if (!CheckCollisionRecs((Rectangle){ cannon->x, cannon->y, CANNON_WIDTH, CANNON_HEIGHT }, renderer->view)) continue;
+
+        float timer = snapshot->cannonTimer[n];
+        SpriteId sprite = (timer < CANNON_SHOOT_TIME) ? SPRITE_CANNON_SHOOT : SPRITE_CANNON_IDLE;
+        int frameCount = (int)(atlas->regions[sprite].width/CANNON_WIDTH);
+        int frame = (int)fminf(timer/CANNON_SHOOT_TIME*frameCount, frameCount - 1);
+
+        Rectangle source = { frame*CANNON_WIDTH, 0, (cannon->facing > 0) ? -CANNON_WIDTH : CANNON_WIDTH, CANNON_HEIGHT };
+        DrawSpriteFrame(atlas, sprite, source, (Vector2){ cannon->x, cannon->y });
+        renderer->spriteCount++;
+    }
+}
+
+// A blast plays once over its lifetime, the other kinds loop
+static void DrawProjectiles(Renderer *renderer, const GameSnapshot *snapshot, float alpha)
+{
+    const Atlas *atlas = &renderer->atlas;
+
+    for (int n = 0; n < snapshot->projectileCount; n++) {
+        const Projectile *p = &snapshot->projectiles[n];
+        const ProjectileSprite *sprite = &projectileSprites[p->kind];
+        Rectangle region = atlas->regions[sprite->sprite];
+        float frameWidth = sprite->frameWidth*spriteSources[sprite->sprite].scale;
+
+        Vector2 position = { Lerp(p->prevX, p->x, alpha) - sprite->offset.x, Lerp(p->prevY, p->y, alpha) - sprite->offset.y };
+        if (!CheckCollisionRecs((Rectangle){ position.x, position.y, frameWidth, region.height }, renderer->view)) continue;
+
+        int frameCount = (int)(region.width/frameWidth);
+        if (frameCount < 1) frameCount = 1;
+        float lifetime = projectileDescs[p->kind].lifetime, age = lifetime - p->life;
+        int frame = (p->kind == PROJECTILE_BLAST) ? (int)fminf(age/lifetime*frameCount, frameCount - 1)
+                                                  : (int)(age/ENEMY_FRAME_TIME)%frameCount;
+
+        DrawSpriteFrame(atlas, sprite->sprite, (Rectangle){ frame*frameWidth, 0, frameWidth, region.height }, position);
+        renderer->spriteCount++;
+    }
+}
+
+void DrawWorld(Renderer *renderer, const GameSnapshot *snapshot, float alpha)
+{
+    const Atlas *atlas = &renderer->atlas;
+    const Level *level = renderer->level;
+    Rectangle view = renderer->view;
+    Rectangle player = GetInterpolatedPlayer(snapshot, alpha);
+
+    // Select the current sprite & frameCount for the state
+    int frameCount = 1;
+    SpriteId currentSprite = SPRITE_KING_IDLE;
+    switch(snapshot->state){
+        case PLAYER_IDLE: frameCount = renderer->idleFrameCount; currentSprite = SPRITE_KING_IDLE; break;
+        case PLAYER_RUN:  frameCount = renderer->runFrameCount;  currentSprite = SPRITE_KING_RUN;  break;
+        case PLAYER_JUMP: frameCount = renderer->jumpFrameCount; currentSprite = SPRITE_KING_JUMP; break;
+        case PLAYER_FALL: frameCount = renderer->fallFrameCount; currentSprite = SPRITE_KING_FALL; break;
+        case PLAYER_HIT:  frameCount = renderer->hitFrameCount;  currentSprite = SPRITE_KING_HIT;  break;
+    }
+
+    int frame = snapshot->frame % frameCount;
+    if (snapshot->state == PLAYER_HIT) {
+        // Player hit frames follow the hit timer
+        float t = snapshot->hitTimer / PLAYER_HIT_DURATION;
+        if (t < 0) t = 0;
+        if (t > 1) t = 1;
+        frame = (int)(t * (renderer->hitFrameCount - 1));
+    }
+
+    // Build source rectangle for player sprite
+    Rectangle sourceRec = { frame * renderer->frameWidth, 0,
+                           snapshot->facingRight ? renderer->frameWidth : -renderer->frameWidth, renderer->frameHeight };
+
+    int visible[MAX_VISIBLE];
+    int visibleCount;
+    int chunkCount = 0;
+
+    renderer->spriteCount = 0;
+
+    BeginMode2D(renderer->camera);
+
+        // Static layer: the baked chunks that meet the view. A chunk the
+        // cache had no room for is drawn sprite by sprite instead.
+        int col0, row0, col1, row1;
+        GetChunkRange(renderer, view, &col0, &row0, &col1, &row1);
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                Rectangle area = GetChunkArea(col, row);
+                const StaticChunk *chunk = FindStaticChunk(renderer, col, row);
+                if (chunk == NULL) {
+                    DrawStaticGeometry(renderer, GetCollisionRec(area, view));
+                    continue;
+                }
+
+                // Render textures are stored upside down
+                DrawTextureRec(chunk->texture.texture, (Rectangle){ 0, 0, STATIC_CHUNK_SIZE, -STATIC_CHUNK_SIZE },
+                               (Vector2){ area.x, area.y }, WHITE);
+                chunkCount++;
+            }
+        }
+
+        // Draw spikeheads (only the active ones are in the snapshot)
+        for (int n = 0; n < snapshot->spikeHeadCount; n++) {
+            float x = level->spikeHeads[snapshot->spikeFirst + n].x;
+            float y = Lerp(snapshot->spikePrevY[n], snapshot->spikeY[n], alpha);
+            if (CheckCollisionRecs((Rectangle){ x, y, atlas->regions[SPRITE_SPIKEHEAD].width,
+                                                atlas->regions[SPRITE_SPIKEHEAD].height }, view)) {
+                DrawSprite(atlas, SPRITE_SPIKEHEAD, x, y);
+                renderer->spriteCount++;
+            }
+        }
+
+        // Draw diamonds with animation (the sprite sits 10 px left of the hitbox)
+        Rectangle diamondView = { view.x, view.y, view.width + 10, view.height };
+        visibleCount = QuerySpatialGrid(&renderer->diamondGrid, diamondView, visible, MAX_VISIBLE);
+        for (int n = 0; n < visibleCount; n++) {
+            int i = visible[n];
+            int k = i - snapshot->diamondFirst;
+            if (k < 0 || k >= snapshot->diamondCount) continue;
+            if (snapshot->diamondActive[k]) {
+                Rectangle sourceRecDiamond = {
+                    snapshot->diamondFrame[k] * renderer->diamondFrameWidth, 0, renderer->diamondFrameWidth, renderer->diamondFrameHeight
+                };
+                DrawSpriteFrame(atlas, SPRITE_DIAMOND, sourceRecDiamond, (Vector2){ level->diamonds[i].x -10, level->diamonds[i].y });
+                renderer->spriteCount++;
+            }
+        }
+
+        DrawCannons(renderer, snapshot);
+        DrawEnemies(renderer, snapshot, alpha);
+
+        // Draw player
+        Vector2 drawPos = { player.x - PLAYER_HITBOX_OFFSET_X, player.y - PLAYER_HITBOX_OFFSET_Y };
+        if (!snapshot->facingRight) drawPos.x = player.x - PLAYER_HITBOX_OFFSET_X - player.width/2 - 5;
+        DrawSpriteFrame(atlas, currentSprite, sourceRec, drawPos);
+        renderer->spriteCount++;
+        // Draw player hitbox
+        //DrawRectangleLinesEx(player, 2, RED);
+
+        DrawProjectiles(renderer, snapshot, alpha);
+
+        // Particles on top, debris still in the atlas batch
+        int debris = DrawParticles(&renderer->particles, atlas, view, false);
+        int squares = DrawParticles(&renderer->particles, atlas, view, true);
+        renderer->particleCount = debris + squares;
+
+    EndMode2D();
+
+    // Not measured, rlgl does not report its flushes: every chunk is its own
+    // texture, then all sprites share the atlas batch and plain particles need
+    // one more. A batch holds a limited number of quads, past that rlgl
+    // flushes on its own.
+    int quads = renderer->spriteCount + renderer->particleCount;
+    renderer->estimatedDrawCalls = chunkCount + 1 + ((squares > 0) ? 1 : 0) + quads/RL_DEFAULT_BATCH_BUFFER_ELEMENTS;
+}
+
+void DrawHud(const GameSnapshot *snapshot)
+{
+    // UI: score & instructions
+    DrawText(TextFormat("Score: %d/%d", snapshot->score, snapshot->diamondTotal), 10, 40, 20, BLACK);
+    DrawText("Press SPACE to jump", 10, 10, 20, BLACK);
+    DrawText("Use A and D to move", 10, 70, 20, BLACK);
+
+    // Draw lives as hearts (simple circles)
+    for (int i = 0; i < snapshot->lives; i++) {
+        DrawCircle(30 + i * 30, 120, 10, RED);
+    }
+    DrawText("Lives", 10, 95, 12, BLACK);
+
+    // Win condition
+    if (snapshot->won) {
+        DrawText("LEVEL COMPLETE!", SCREEN_WIDTH/2 - 150, SCREEN_HEIGHT/2 - 50, 40, GREEN);
+        DrawText("All diamonds collected!", SCREEN_WIDTH/2 - 120, SCREEN_HEIGHT/2, 30, GREEN);
+        DrawText("Press R to Restart", SCREEN_WIDTH/2 - 100, SCREEN_HEIGHT/2 + 40, 20, BLACK);
+    }
+
+    // Lose condition & restart prompt
+    if (snapshot->over) {
+        DrawText("YOU DIED!", SCREEN_WIDTH/2 - 150, SCREEN_HEIGHT/2 - 50, 40, RED);
+        DrawText("Press R to Restart", SCREEN_WIDTH/2 - 100, SCREEN_HEIGHT/2 + 10, 20, BLACK);
+    }
+}
+
+void DrawLoadingScreen(float progress)
+{
+    const int barWidth = 400;
+    const int barX = SCREEN_WIDTH/2 - barWidth/2;
+    const int barY = SCREEN_HEIGHT/2;
+
+    DrawText("Loading...", barX, barY - 40, 30, BLACK);
+    DrawRectangle(barX, barY, barWidth, 20, Fade(BLACK, 0.3f));
+    DrawRectangle(barX, barY, (int)(barWidth*progress), 20, DARKBLUE);
+    DrawText(TextFormat("%d%%", (int)(progress*100.0f)), barX + barWidth + 10, barY, 20, BLACK);
+}
+
+void DrawProfilerOverlay(const Renderer *renderer)
+{
+    static const ProfileZone shownZones[] = {
+        PROFILE_FRAME, PROFILE_UPDATE, PROFILE_TICK, PROFILE_PLAYER, PROFILE_SPIKEHEADS,
+        PROFILE_ENEMIES, PROFILE_PROJECTILES, PROFILE_DIAMONDS, PROFILE_CAMERA, PROFILE_PARTICLES, PROFILE_DRAW_WORLD, PROFILE_DRAW_HUD, PROFILE_SWAP
+    };
+    const int zoneCount = sizeof(shownZones)/sizeof(shownZones[0]);
+    const int lineHeight = 14;
+    const int x = OVERLAY_X + 8;
+    const int columns[3] = { x + 150, x + 225, x + 300 };
+
+    DrawRectangle(OVERLAY_X, OVERLAY_Y, OVERLAY_WIDTH, 50 + zoneCount*lineHeight + OVERLAY_GRAPH_HEIGHT, Fade(BLACK, 0.7f));
+
+    // Estimated, plus one for the HUD text batch on top of the world
+    int y = OVERLAY_Y + 6;
+    DrawText(TextFormat("%d fps   est. draw calls: %d   sprites: %d   particles: %d", GetFPS(), renderer->estimatedDrawCalls + 1,
+                        renderer->spriteCount, renderer->particleCount), x, y, 10, RAYWHITE);
+    y += lineHeight + 4;
+
+    DrawText("ms", x, y, 10, GRAY);
+    DrawText("min", columns[0], y, 10, GRAY);
+    DrawText("avg", columns[1], y, 10, GRAY);
+    DrawText("p99", columns[2], y, 10, GRAY);
+    y += lineHeight;
+
+    for (int i = 0; i < zoneCount; i++) {
+        ProfileStats stats = GetProfileStats(shownZones[i]);
+        DrawText(profileZoneNames[shownZones[i]], x, y, 10, RAYWHITE);
+        DrawText(TextFormat("%.3f", stats.min*1000.0f), columns[0], y, 10, RAYWHITE);
+        DrawText(TextFormat("%.3f", stats.avg*1000.0f), columns[1], y, 10, RAYWHITE);
+        DrawText(TextFormat("%.3f", stats.p99*1000.0f), columns[2], y, 10, RAYWHITE);
+        y += lineHeight;
+    }
+
+    // Frame-time graph, newest frame on the right, with the 60 and 30 fps budgets
+    const int graphWidth = OVERLAY_WIDTH - 16;
+    const int bottom = y + 4 + OVERLAY_GRAPH_HEIGHT;
+    const float pixelsPerMs = OVERLAY_GRAPH_HEIGHT/OVERLAY_GRAPH_MAX_MS;
+    const int line60 = bottom - (int)(1000.0f/60.0f*pixelsPerMs);
+    const int line30 = bottom - (int)(1000.0f/30.0f*pixelsPerMs);
+
+    for (int age = 0; age < graphWidth && age < PROFILE_HISTORY; age++) {
+        float ms = GetProfileHistory(PROFILE_FRAME, age)*1000.0f;
+        if (ms > OVERLAY_GRAPH_MAX_MS) ms = OVERLAY_GRAPH_MAX_MS;
+        int barHeight = (int)(ms*pixelsPerMs);
+        int barY = bottom - barHeight;
+        Color color = (barY <= line30) ? RED : (barY < line60 - 1) ? ORANGE : GREEN;
+        DrawRectangle(x + graphWidth - 1 - age, barY, 1, barHeight, color);
+    }
+    DrawLine(x, line60, x + graphWidth, line60, Fade(RAYWHITE, 0.5f));
+    DrawLine(x, line30, x + graphWidth, line30, Fade(RED, 0.5f));
+}
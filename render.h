@@ -0,0 +1,105 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "raylib.h"
+#include "game.h"
+#include "atlas.h"
+#include "particles.h"
+#include "profile.h"
+
+// Static level geometry (background, platforms, ground) is baked into
+// square render texture chunks and drawn as a few quads. Only the chunks
+// around the camera are kept, in a small cache that re-bakes as the camera
+// moves, so texture memory does not grow with the level size.
+#define STATIC_CHUNK_SIZE 1024
+#define STATIC_CHUNK_CACHE 8
+
+typedef struct {
+    RenderTexture2D texture;    // allocated on first use
+    int col;                    // -1 while empty
+    int row;
+    unsigned int lastUsed;      // frame it was last needed, evicts least recently used
+} StaticChunk;
+
+// Everything after InitRenderer draws from GameSnapshots, so the renderer
+// never reads the live Game while the simulation thread updates it
+typedef struct {
+    Atlas atlas;
+    AtlasReloader reloader;     // hot reload of changed sprites
+    AtlasLoader repack;         // full repack after a sprite changed size
+    bool repacking;
+    const Level *level;
+    float worldWidth;
+    float worldHeight;
+    Arena arena;                // level lifetime data of the renderer
+    SpatialGrid platformGrid;   // own copies: grid queries are not thread-safe
+    SpatialGrid diamondGrid;
+    float diamondWidth;
+    float diamondHeight;
+
+    StaticChunk chunks[STATIC_CHUNK_CACHE];
+    int chunkCols;              // chunks covering the whole world
+    int chunkRows;
+    unsigned int chunkFrame;
+    float lastCameraX;          // to bake ahead in the direction of travel
+    Camera2D camera;
+    Vector2 cameraDefaultOffset;
+    Rectangle view;         // world area visible through the camera
+
+    Particles particles;
+    unsigned int eventsSeen;    // GameSnapshot.eventCount already turned into effects
+
+    // Last DrawWorld: texture batches raylib should have flushed (estimated
+    // from the chunks and quads drawn), sprites and particles submitted
+    int estimatedDrawCalls;
+    int spriteCount;
+    int particleCount;
+
+    // Player sprite frames
+    int frameWidth;
+    int frameHeight;
+    int idleFrameCount;
+    int runFrameCount;
+    int jumpFrameCount;
+    int fallFrameCount;
+    int hitFrameCount;
+
+    // Diamond animation frames
+    int diamondFrameWidth;
+    int diamondFrameHeight;
+} Renderer;
+
+// Takes ownership of the loaded atlas, which is unloaded again on failure.
+// Returns false when out of memory.
+bool InitRenderer(Renderer *renderer, Game *game, Atlas atlas);
+void UnloadRenderer(Renderer *renderer);
+
+// Drop the baked chunks, call whenever the level geometry or its sprites
+// change. They re-bake on demand.
+void InvalidateStaticLayer(Renderer *renderer);
+
+// Swap in sprites changed on disk since the last frame, without a restart
+void UpdateAssetReload(Renderer *renderer);
+
+// Follow the player (interpolated by alpha between the last two ticks)
+void UpdateRenderCamera(Renderer *renderer, const GameSnapshot *snapshot, float alpha);
+
+// Bake the chunks the camera sees that are not cached yet, plus at most one
+// chunk ahead of it. Call after the camera update, outside BeginDrawing.
+void UpdateStaticLayer(Renderer *renderer);
+
+// Spawn particles for the game events since the last call and move them
+// by dt, the real time since the last frame
+void UpdateParticleEffects(Renderer *renderer, const GameSnapshot *snapshot, float dt);
+
+// Draw what the camera sees, culled against the view
+void DrawWorld(Renderer *renderer, const GameSnapshot *snapshot, float alpha);
+void DrawHud(const GameSnapshot *snapshot);
+
+// Shown while the assets load in the background, progress in 0..1
+void DrawLoadingScreen(float progress);
+
+// Frame profiler: rolling min/avg/p99 of every zone and a frame-time graph
+void DrawProfilerOverlay(const Renderer *renderer);
+
+#endif
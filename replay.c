@@ -0,0 +1,172 @@
+#include "replay.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+static unsigned int HashBytes(unsigned int hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i])*FNV_PRIME;
+    return hash;
+}
+
+// Ticks starting at `start` that repeat the same input, capped at 255
+static int GetRunLength(const InputLog *log, int start)
+{
+    int length = 1;
+    while (start + length < log->count && length < 255 && log->ticks[start + length] == log->ticks[start]) length++;
+    return length;
+}
+
+unsigned char PackGameInput(const GameInput *input)
+{
+    return (input->left ? REPLAY_INPUT_LEFT : 0) | (input->right ? REPLAY_INPUT_RIGHT : 0) |
+           (input->jump ? REPLAY_INPUT_JUMP : 0) | (input->restart ? REPLAY_INPUT_RESTART : 0);
+}
+
+GameInput UnpackGameInput(unsigned char packed)
+{
+    return (GameInput){
+        .left = (packed & REPLAY_INPUT_LEFT) != 0,
+        .right = (packed & REPLAY_INPUT_RIGHT) != 0,
+        .jump = (packed & REPLAY_INPUT_JUMP) != 0,
+        .restart = (packed & REPLAY_INPUT_RESTART) != 0
+    };
+}
+
+void RecordInput(InputLog *log, const GameInput *input)
+{
+    if (log->failed) return;
+    if (log->count == log->capacity) {
+        int capacity = (log->capacity > 0) ? log->capacity*2 : 4096;
+        unsigned char *ticks = realloc(log->ticks, capacity);
+        if (ticks == NULL) {
+            log->failed = true;
+            return;
+        }
+        log->ticks = ticks;
+        log->capacity = capacity;
+    }
+    log->ticks[log->count++] = PackGameInput(input);
+}
+
+bool SaveInputLog(InputLog *log, const char *path, const Level *level, const char *levelPath, const Game *game)
+{
+    if (log->failed) return false;
+
+    ReplayHeader *header = &log->header;
+    *header = (ReplayHeader){
+        .magic = REPLAY_MAGIC,
+        .version = REPLAY_VERSION,
+        .tickRate = TICK_RATE,
+        .tickCount = log->count,
+        .levelHash = HashLevel(level),
+        .stateHash = HashGameState(game)
+    };
+    strncpy(header->levelPath, levelPath, sizeof(header->levelPath) - 1);
+
+    for (int i = 0; i < log->count; header->runCount++) i += GetRunLength(log, i);
+
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) return false;
+
+    bool ok = (fwrite(header, sizeof(ReplayHeader), 1, out) == 1);
+    for (int i = 0; i < log->count && ok;) {
+        ReplayRun run = { log->ticks[i], (unsigned char)GetRunLength(log, i) };
+        ok = (fwrite(&run, sizeof(ReplayRun), 1, out) == 1);
+        i += run.length;
+    }
+
+    if (fclose(out) != 0) ok = false;
+    return ok;
+}
+
+bool LoadInputLog(const char *path, InputLog *log)
+{
+    *log = (InputLog){ 0 };
+
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) return false;
+
+    ReplayHeader *header = &log->header;
+    bool ok = (fread(header, sizeof(ReplayHeader), 1, in) == 1) && header->magic == REPLAY_MAGIC &&
+              header->version == REPLAY_VERSION && header->tickRate == TICK_RATE;
+    header->levelPath[sizeof(header->levelPath) - 1] = '\0';
+
+    // Runs hold at most 255 ticks each, and counts must fit an int
+    if (ok) ok = header->tickCount <= INT_MAX && header->tickCount <= (unsigned long long)header->runCount*255;
+
+    if (ok) {
+        log->ticks = malloc((size_t)header->tickCount + 1);
+        log->capacity = (int)header->tickCount;
+        ok = (log->ticks != NULL);
+    }
+
+    for (unsigned int r = 0; r < header->runCount && ok; r++) {
+        ReplayRun run;
+        ok = (fread(&run, sizeof(ReplayRun), 1, in) == 1) && run.length > 0 &&
+             (unsigned int)log->count + run.length <= header->tickCount;
+        if (ok) {
+            memset(log->ticks + log->count, run.input, run.length);
+            log->count += run.length;
+        }
+    }
+    if (ok) ok = ((unsigned int)log->count == header->tickCount);
+
+    fclose(in);
+    if (!ok) FreeInputLog(log);
+    return ok;
+}
+
+void FreeInputLog(InputLog *log)
+{
+    free(log->ticks);
+    *log = (InputLog){ 0 };
+}
+
+unsigned int HashLevel(const Level *level)
+{
+    return HashBytes(FNV_OFFSET, level->file.data, level->file.size);
+}
+
+unsigned int HashGameState(const Game *game)
+{
+    unsigned int hash = FNV_OFFSET;
+    hash = HashBytes(hash, &game->player, sizeof(game->player));
+    hash = HashBytes(hash, &game->velocityY, sizeof(game->velocityY));
+    hash = HashBytes(hash, &game->hitTimer, sizeof(game->hitTimer));
+    hash = HashBytes(hash, &game->frameTimer, sizeof(game->frameTimer));
+    hash = HashBytes(hash, &game->frame, sizeof(game->frame));
+    hash = HashBytes(hash, &game->lives, sizeof(game->lives));
+    hash = HashBytes(hash, &game->score, sizeof(game->score));
+
+    const SpikeHeads *spikes = &game->spikeHeads;
+    hash = HashBytes(hash, spikes->y, spikes->count*sizeof(float));
+    hash = HashBytes(hash, spikes->vy, spikes->count*sizeof(float));
+
+    const Diamonds *diamonds = &game->diamonds;
+    hash = HashBytes(hash, diamonds->active, diamonds->count*sizeof(int));
+    hash = HashBytes(hash, diamonds->frame, diamonds->count*sizeof(int));
+
+    const Enemies *enemies = &game->enemies;
+    hash = HashBytes(hash, enemies->x, enemies->count*sizeof(float));
+    hash = HashBytes(hash, enemies->y, enemies->count*sizeof(float));
+    hash = HashBytes(hash, enemies->state, enemies->count*sizeof(int));
+
+    // Projectiles in pool order, which is deterministic too
+    const Pool *projectiles = &game->projectiles;
+    for (int i = 0; i < projectiles->highWater; i++) {
+        const Projectile *p = GetPoolItem(projectiles, i);
+        if (p == NULL) continue;
+        hash = HashBytes(hash, &p->x, sizeof(p->x));
+        hash = HashBytes(hash, &p->y, sizeof(p->y));
+        hash = HashBytes(hash, &p->kind, sizeof(p->kind));
+    }
+    hash = HashBytes(hash, game->cannonTimers, game->level->header->cannonCount*sizeof(float));
+    return hash;
+}
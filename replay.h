@@ -0,0 +1,62 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+
+// Input log (.rpl): the GameInput of every tick since InitGame, so a
+// session replays bit-for-bit. Each tick packs into one byte and the file
+// stores runs of identical bytes. The header records a hash of the level
+// file and of the final game state so a replay can prove it matched.
+#define REPLAY_MAGIC 0x314c5052     // "RPL1"
+#define REPLAY_VERSION 1
+#define REPLAY_DEFAULT_PATH "session.rpl"
+
+#define REPLAY_INPUT_LEFT 0x01
+#define REPLAY_INPUT_RIGHT 0x02
+#define REPLAY_INPUT_JUMP 0x04
+#define REPLAY_INPUT_RESTART 0x08
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int tickRate;
+    unsigned int tickCount;
+    unsigned int levelHash;
+    unsigned int stateHash;     // HashGameState after the last tick
+    unsigned int runCount;
+    char levelPath[128];
+} ReplayHeader;
+
+typedef struct {
+    unsigned char input;
+    unsigned char length;       // 1..255 ticks
+} ReplayRun;
+
+typedef struct {
+    ReplayHeader header;
+    unsigned char *ticks;       // one packed input per tick
+    int count;
+    int capacity;
+    bool failed;                // a tick could not be stored, the log would desync
+} InputLog;
+
+unsigned char PackGameInput(const GameInput *input);
+GameInput UnpackGameInput(unsigned char packed);
+
+// Append one tick, call right before UpdateGame with the same input. Out
+// of memory, it marks the log failed and records nothing more.
+void RecordInput(InputLog *log, const GameInput *input);
+
+// Write the log, stamping it with the level and the game's current state.
+// False for a failed log, which is not written.
+bool SaveInputLog(InputLog *log, const char *path, const Level *level, const char *levelPath, const Game *game);
+
+// Read a log written by SaveInputLog, false if missing or malformed
+bool LoadInputLog(const char *path, InputLog *log);
+void FreeInputLog(InputLog *log);
+
+// FNV-1a over the level file and over the simulation state
+unsigned int HashLevel(const Level *level);
+unsigned int HashGameState(const Game *game);
+
+#endif
@@ -0,0 +1,133 @@
+#if !defined(_WIN32)
+    #define _POSIX_C_SOURCE 199309L
+    #include <time.h>
+#endif
+
+#include "simthread.h"
+#include "profile.h"
+#include "jobs.h"
+
+#if defined(_WIN32)
+    // Declared here rather than through windows.h, which clashes with raylib names
+    __declspec(dllimport) void __stdcall Sleep(unsigned long milliseconds);
+#endif
+
+static void SleepSeconds(double seconds)
+{
+    if (seconds <= 0.0) return;
+#if defined(_WIN32)
+    Sleep((unsigned long)(seconds*1000.0));
+#else
+    struct timespec duration = { (time_t)seconds, (long)((seconds - (time_t)seconds)*1e9) };
+    nanosleep(&duration, NULL);
+#endif
+}
+
+static void PublishSnapshot(SimThread *sim, double time, long long tick)
+{
+    GameSnapshot *snapshot = &sim->snapshots[sim->write];
+    CaptureGameSnapshot(sim->game, snapshot);
+    snapshot->time = time;
+    snapshot->tick = tick;
+
+    pthread_mutex_lock(&sim->lock);
+    int ready = sim->ready;
+    sim->ready = sim->write;
+    sim->write = ready;
+    sim->fresh = true;
+    pthread_mutex_unlock(&sim->lock);
+}
+
+static void *SimThreadMain(void *arg)
+{
+    SimThread *sim = arg;
+    SetProfileThread(PROFILE_THREAD_SIM);
+    AttachJobThread();
+
+    double simTime = GetProfileTime();      // when the next tick is due
+    long long tick = 0;
+
+    while (__atomic_load_n(&sim->running, __ATOMIC_ACQUIRE)) {
+        double now = GetProfileTime();
+        if (now - simTime > MAX_FRAME_TIME) simTime = now - MAX_FRAME_TIME;
+
+        // Run every tick that is due, then publish the newest state
+        if (simTime <= now) {
+            PROFILE_BEGIN(PROFILE_UPDATE);
+            while (simTime <= now) {
+                pthread_mutex_lock(&sim->lock);
+                GameInput input = sim->input;
+                sim->input.jump = false;
+                sim->input.restart = false;
+                pthread_mutex_unlock(&sim->lock);
+
+                if (sim->record != NULL) RecordInput(sim->record, &input);
+                UpdateGame(sim->game, &input);
+                simTime += TICK_DT;
+                tick++;
+            }
+            PROFILE_END(PROFILE_UPDATE);
+
+            // The state now shown is the tick that was due one step ago
+            PublishSnapshot(sim, simTime - TICK_DT, tick);
+        }
+
+        SleepSeconds(simTime - GetProfileTime());
+    }
+    DetachJobThread();
+    return NULL;
+}
+
+bool StartSimThread(SimThread *sim, Game *game, InputLog *record)
+{
+    *sim = (SimThread){ .game = game, .record = record, .write = 0, .ready = 1, .read = 2 };
+
+    for (int i = 0; i < 3; i++) {
+        if (!AllocGameSnapshot(&sim->snapshots[i], game)) {
+            for (int j = 0; j < i; j++) FreeGameSnapshot(&sim->snapshots[j]);
+            return false;
+        }
+        CaptureGameSnapshot(game, &sim->snapshots[i]);
+        sim->snapshots[i].time = GetProfileTime();
+    }
+
+    pthread_mutex_init(&sim->lock, NULL);
+    sim->running = true;
+    if (pthread_create(&sim->thread, NULL, SimThreadMain, sim) != 0) {
+        pthread_mutex_destroy(&sim->lock);
+        for (int i = 0; i < 3; i++) FreeGameSnapshot(&sim->snapshots[i]);
+        return false;
+    }
+    return true;
+}
+
+void StopSimThread(SimThread *sim)
+{
+    __atomic_store_n(&sim->running, false, __ATOMIC_RELEASE);
+    pthread_join(sim->thread, NULL);
+    pthread_mutex_destroy(&sim->lock);
+    for (int i = 0; i < 3; i++) FreeGameSnapshot(&sim->snapshots[i]);
+}
+
+void SetSimInput(SimThread *sim, const GameInput *input)
+{
+    pthread_mutex_lock(&sim->lock);
+    sim->input.left = input->left;
+    sim->input.right = input->right;
+    sim->input.jump = sim->input.jump || input->jump;
+    sim->input.restart = sim->input.restart || input->restart;
+    pthread_mutex_unlock(&sim->lock);
+}
+
+const GameSnapshot *AcquireSnapshot(SimThread *sim)
+{
+    pthread_mutex_lock(&sim->lock);
+    if (sim->fresh) {
+        int read = sim->read;
+        sim->read = sim->ready;
+        sim->ready = read;
+        sim->fresh = false;
+    }
+    pthread_mutex_unlock(&sim->lock);
+    return &sim->snapshots[sim->read];
+}
@@ -0,0 +1,48 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "game.h"
+#include "replay.h"
+
+#include <pthread.h>
+
+// Runs the fixed-rate simulation on its own thread. raylib and its GL
+// context stay on the main thread, which samples input and draws the most
+// recent snapshot while the next tick is being simulated.
+//
+// Snapshots are triple buffered: the simulation fills `write`, publishes
+// it by swapping with `ready`, and the renderer swaps `ready` into `read`
+// when a newer one is there. Neither side ever waits for the other.
+
+// Longest stall the simulation will catch up on; beyond this the game slows down
+#define MAX_FRAME_TIME 0.25f
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;       // guards input and the snapshot indices
+    bool running;
+
+    Game *game;
+    InputLog *record;           // every tick's input is appended when not NULL
+
+    GameInput input;            // latest input from the main thread
+    GameSnapshot snapshots[3];
+    int write;
+    int ready;
+    int read;
+    bool fresh;                 // ready holds a snapshot the renderer has not taken
+} SimThread;
+
+// Start ticking game on a new thread. The game must not be touched by
+// the caller until StopSimThread returns.
+bool StartSimThread(SimThread *sim, Game *game, InputLog *record);
+void StopSimThread(SimThread *sim);
+
+// Hand over the input for the coming ticks. Jump and restart presses stay
+// latched until a tick consumes them.
+void SetSimInput(SimThread *sim, const GameInput *input);
+
+// Most recent complete tick, valid until the next call
+const GameSnapshot *AcquireSnapshot(SimThread *sim);
+
+#endif
@@ -0,0 +1,33 @@
+// Offline asset bake: loads every sprite the game draws, scales it to its
+// in-game size, packs the atlas and writes the GPU-ready pixels to
+// Sprites/atlas.pack so startup is a single file read and texture upload.
+// Run from the project root after changing anything under Sprites/.
+#include "raylib.h"
+#include "../atlas.h"
+
+#include <stdio.h>
+
+int main(void)
+{
+    Image images[SPRITE_COUNT];
+    if (!LoadSpriteImages(images, NULL)) {
+        fprintf(stderr, "bake_assets: failed to load sprite sources\n");
+        return 1;
+    }
+
+    Image atlas;
+    Rectangle regions[SPRITE_COUNT];
+    if (!PackAtlas(images, SPRITE_COUNT, &atlas, regions)) {
+        fprintf(stderr, "bake_assets: sprites do not fit in one atlas\n");
+        return 1;
+    }
+
+    bool ok = SaveAtlasPack(atlas, regions);
+    if (ok) printf("bake_assets: %i sprites into %ix%i -> %s\n", SPRITE_COUNT, atlas.width, atlas.height, ATLAS_PACK_PATH);
+    else fprintf(stderr, "bake_assets: cannot write %s\n", ATLAS_PACK_PATH);
+
+    UnloadImage(atlas);
+    for (int i = 0; i < SPRITE_COUNT; i++) UnloadImage(images[i]);
+
+    return ok ? 0 : 1;
+}
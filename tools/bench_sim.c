@@ -0,0 +1,403 @@
+// Headless simulation benchmark: runs the game logic from a scripted input
+// stream as fast as possible, with no window, and reports ticks per second
+// and the time spent in each system. Links without raylib.
+//   bench_sim [-j workers] [-n ticks] [-l level.lvl] [-o record.rpl] [script.txt]
+//   bench_sim [-j workers] -r session.rpl [-p passes]
+//   bench_sim --navchk [-l level.lvl]
+//
+// A script is a list of "<ticks> <keys>" steps that loops until the tick
+// count is reached. Keys: L left, R right, J jump, X restart, - none.
+// -o saves the scripted run as an input log. -r replays an input log
+// (recorded with game --record) instead, checking that the final state
+// matches the recording bit-for-bit; the exit code is 2 when it does not.
+// -j sets the job system's worker threads (default: one per extra core).
+// --navchk runs no benchmark: it checks the navigation cache invalidation
+// on the level instead, with exit code 2 when the check fails.
+#include "../game.h"
+#include "../profile.h"
+#include "../replay.h"
+#include "../jobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_TICKS 1000000
+#define DEFAULT_SCRIPT_PATH "tools/bench_input.txt"
+#define MAX_STEPS 1024
+
+typedef struct {
+    int ticks;
+    GameInput input;
+} InputStep;
+
+static int LoadInputScript(const char *path, InputStep *steps, int maxSteps)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL) { fprintf(stderr, "bench_sim: cannot open %s\n", path); return 0; }
+
+    int count = 0;
+    char line[256];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), in) != NULL && count < maxSteps) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        int ticks;
+        char keys[32];
+        int parsed = sscanf(line, "%d %31s", &ticks, keys);
+        if (parsed <= 0) continue;
+        if (parsed != 2 || ticks <= 0) {
+            fprintf(stderr, "bench_sim: %s:%d: expected \"<ticks> <keys>\"\n", path, lineNumber);
+            fclose(in);
+            return 0;
+        }
+
+        InputStep *step = &steps[count++];
+        *step = (InputStep){ .ticks = ticks };
+        step->input.left = strchr(keys, 'L') != NULL;
+        step->input.right = strchr(keys, 'R') != NULL;
+        step->input.jump = strchr(keys, 'J') != NULL;
+        step->input.restart = strchr(keys, 'X') != NULL;
+    }
+
+    fclose(in);
+    if (count == 0) fprintf(stderr, "bench_sim: %s has no input steps\n", path);
+    return count;
+}
+
+static void PrintProfile(void)
+{
+#if !defined(NO_PROFILE)
+    const double tickTotal = profileCounters[PROFILE_TICK].total;
+    printf("\n%-12s %12s %10s %8s\n", "system", "calls", "ns/call", "% tick");
+    for (int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+        const ProfileCounter *counter = &profileCounters[i];
+        if (counter->calls == 0) continue;
+        printf("%-12s %12lld %10.1f %7.1f%%\n", profileZoneNames[i], counter->calls,
+               counter->total*1e9/counter->calls, (tickTotal > 0) ? 100.0*counter->total/tickTotal : 0.0);
+    }
+#endif
+}
+
+static void PrintRate(long long tickCount, double elapsed)
+{
+    printf("ticks   %lld in %.3f s\n", tickCount, elapsed);
+    printf("rate    %.0f ticks/s (%.0fx real time)\n", tickCount/elapsed, tickCount/elapsed/TICK_RATE);
+}
+
+// Replay an input log `passes` times from a fresh game each time
+static int RunReplay(const char *replayPath, const char *levelPath, int passes)
+{
+    InputLog log;
+    if (!LoadInputLog(replayPath, &log)) { fprintf(stderr, "bench_sim: cannot load %s\n", replayPath); return 1; }
+    if (levelPath == NULL) levelPath = log.header.levelPath;
+
+    Level level;
+    if (!LoadLevel(levelPath, &level)) {
+        fprintf(stderr, "bench_sim: cannot load %s\n", levelPath);
+        FreeInputLog(&log);
+        return 1;
+    }
+    if (HashLevel(&level) != log.header.levelHash)
+        fprintf(stderr, "bench_sim: warning: %s differs from the level that was recorded\n", levelPath);
+
+    ResetProfile();
+    int mismatches = 0;
+    unsigned int stateHash = 0;
+    double elapsed = 0.0;
+
+    for (int pass = 0; pass < passes; pass++) {
+        Game game;
+        if (!InitGame(&game, &level)) {
+            fprintf(stderr, "bench_sim: cannot set up %s\n", levelPath);
+            UnloadLevel(&level);
+            FreeInputLog(&log);
+            return 1;
+        }
+
+        double start = GetProfileTime();
+        for (int tick = 0; tick < log.count; tick++) {
+            GameInput input = UnpackGameInput(log.ticks[tick]);
+            UpdateGame(&game, &input);
+        }
+        elapsed += GetProfileTime() - start;
+
+        stateHash = HashGameState(&game);
+        if (stateHash != log.header.stateHash) mismatches++;
+        UnloadGame(&game);
+    }
+
+    printf("level   %s\n", levelPath);
+    printf("replay  %s (%d ticks, %.1f s of play, %u runs)\n", replayPath, log.count,
+           (float)log.count/TICK_RATE, log.header.runCount);
+    PrintRate((long long)log.count*passes, elapsed);
+    printf("state   %08x, recorded %08x: %s\n", stateHash, log.header.stateHash,
+           (mismatches == 0) ? "match" : "MISMATCH");
+    PrintProfile();
+
+    UnloadLevel(&level);
+    FreeInputLog(&log);
+    return (mismatches == 0) ? 0 : 2;
+}
+
+// Follow the route from start to goal with a fresh search budget at every
+// hop. Returns the hop count (-1 when unreachable) and the spans after start.
+static int WalkNavRoute(NavGraph *nav, int start, int goal, int *spans, int maxSpans)
+{
+    int hops = 0;
+    for (int s = start; s != goal; hops++) {
+        BeginNavTick(nav);
+        int e = FindNavRoute(nav, s, goal);
+        if (e < 0 || hops >= maxSpans) return -1;
+        s = nav->edges[e].to;
+        spans[hops] = s;
+    }
+    return hops;
+}
+
+// Cached first edge only: with no search budget a dropped route reads as -1
+static int PeekNavRoute(NavGraph *nav, int start, int goal)
+{
+    nav->searchesLeft = 0;
+    return FindNavRoute(nav, start, goal);
+}
+
+// Close a span on the longest route to the best connected goal, one with a
+// way around it if there is one. Routes through it must be dropped and
+// found again around it, routes without its span bit must stay cached.
+// Reopen it: the routes kept stay, and every route comes back as it was.
+static bool CheckNavInvalidation(NavGraph *nav)
+{
+    enum { MAX_HOPS = 256, MAX_GOALS = 64 };
+    const int count = nav->spanCount;
+    int route[MAX_HOPS];
+
+    // Goal reached from the most spans, among a spread of candidates
+    int goal = -1, bestReached = 0;
+    int candidates = (count < MAX_GOALS) ? count : MAX_GOALS;
+    for (int c = 0; c < candidates; c++) {
+        int g = (int)((long long)c*count/candidates), reached = 0;
+        ClearNavCache(nav);
+        for (int s = 0; s < count; s++) reached += (WalkNavRoute(nav, s, g, route, MAX_HOPS) > 0);
+        if (reached > bestReached) { bestReached = reached; goal = g; }
+    }
+
+    int *hops = malloc((count + 1)*sizeof(int));
+    int *firstEdge = malloc((count + 1)*sizeof(int));
+    unsigned char *onRoute = malloc(count + 1);     // 1 passes the closed span, 2 shares its span bit
+    if (hops == NULL || firstEdge == NULL || onRoute == NULL) {
+        free(hops); free(firstEdge); free(onRoute);
+        fprintf(stderr, "bench_sim: out of memory for the navigation check\n");
+        return false;
+    }
+
+    // Longest route, and the span on it to close: the first with a way
+    // around, or the middle one
+    int from = -1, longest = 1;
+    ClearNavCache(nav);
+    for (int s = 0; goal >= 0 && s < count; s++) {
+        int n = WalkNavRoute(nav, s, goal, route, MAX_HOPS);
+        if (n > longest) { longest = n; from = s; }
+    }
+    int closed = -1;
+    if (from >= 0) {
+        int longestRoute[MAX_HOPS], around[MAX_HOPS];
+        WalkNavRoute(nav, from, goal, longestRoute, MAX_HOPS);
+        closed = longestRoute[longest/2 - 1];
+        for (int k = 0; k < longest - 1; k++) {
+            SetNavSpanOpen(nav, longestRoute[k], false);
+            bool detour = WalkNavRoute(nav, from, goal, around, MAX_HOPS) >= 0;
+            SetNavSpanOpen(nav, longestRoute[k], true);
+            if (detour) { closed = longestRoute[k]; break; }
+        }
+    }
+
+    ClearNavCache(nav);
+    for (int s = 0; s < count; s++) hops[s] = (goal >= 0) ? WalkNavRoute(nav, s, goal, route, MAX_HOPS) : -1;
+    if (closed < 0) {
+        printf("navchk  no route long enough to close a span on\n");
+        free(hops); free(firstEdge); free(onRoute);
+        return true;
+    }
+
+    // Which cached routes touch it. Slots evicted by another route
+    // (firstEdge -1) are left out of the checks.
+    for (int s = 0; s < count; s++) {
+        onRoute[s] = 0;
+        firstEdge[s] = (hops[s] > 0 && s != closed) ? PeekNavRoute(nav, s, goal) : -1;
+        if (firstEdge[s] < 0) continue;
+        WalkNavRoute(nav, s, goal, route, MAX_HOPS);
+        onRoute[s] = ((s & 63) == (closed & 63)) ? 2 : 0;
+        for (int n = 0; n < hops[s]; n++) {
+            if (route[n] == closed) onRoute[s] = 1;
+            else if ((route[n] & 63) == (closed & 63) && onRoute[s] == 0) onRoute[s] = 2;
+        }
+    }
+
+    bool ok = true;
+    int routes = 0, dropped = 0, aliased = 0, detours = 0;
+    long long searches = nav->searches;
+
+    // Closing drops the routes through the span, and only those sharing
+    // its span bit besides; reopening leaves the rest cached
+    SetNavSpanOpen(nav, closed, false);
+    for (int s = 0; s < count; s++) {
+        if (firstEdge[s] < 0) continue;
+        routes++;
+        int e = PeekNavRoute(nav, s, goal);
+        if (onRoute[s] == 1 && e >= 0) ok = false;
+        if (onRoute[s] == 0 && e != firstEdge[s]) ok = false;
+        dropped += (onRoute[s] == 1);
+        aliased += (onRoute[s] == 2 && e < 0);
+    }
+    SetNavSpanOpen(nav, closed, true);
+    for (int s = 0; s < count; s++) {
+        if (firstEdge[s] >= 0 && onRoute[s] == 0 && PeekNavRoute(nav, s, goal) != firstEdge[s]) ok = false;
+    }
+
+    // Routes found while it is closed go around it, and are dropped again
+    // once it reopens
+    SetNavSpanOpen(nav, closed, false);
+    for (int s = 0; s < count; s++) {
+        if (firstEdge[s] < 0 || onRoute[s] != 1) continue;
+        int n = WalkNavRoute(nav, s, goal, route, MAX_HOPS);
+        for (int k = 0; k < n; k++) if (route[k] == closed) ok = false;
+        detours += (n >= 0);
+    }
+    SetNavSpanOpen(nav, closed, true);
+    long long reopened = nav->searches;
+    for (int s = 0; s < count; s++) {
+        if (firstEdge[s] < 0) continue;
+        if (onRoute[s] == 1 && PeekNavRoute(nav, s, goal) >= 0) ok = false;
+        int n = WalkNavRoute(nav, s, goal, route, MAX_HOPS);
+        if (n != hops[s] || PeekNavRoute(nav, s, goal) != firstEdge[s]) ok = false;
+    }
+
+    printf("navchk  span %d closed: %d of %d routes dropped (+%d sharing its bit), %d found around it; "
+           "reopened: %lld searches, %lld in all: %s\n", closed, dropped, routes, aliased, detours,
+           nav->searches - reopened, nav->searches - searches, ok ? "ok" : "FAILED");
+
+    free(hops); free(firstEdge); free(onRoute);
+    return ok;
+}
+
+// Load a level and run CheckNavInvalidation on its graph
+static int RunNavCheck(const char *levelPath)
+{
+    Level level;
+    if (!LoadLevel(levelPath, &level)) { fprintf(stderr, "bench_sim: cannot load %s\n", levelPath); return 1; }
+
+    Game game;
+    if (!InitGame(&game, &level)) {
+        fprintf(stderr, "bench_sim: cannot set up %s\n", levelPath);
+        UnloadLevel(&level);
+        return 1;
+    }
+
+    printf("level   %s (%d spans, %d edges)\n", levelPath, game.nav.spanCount, game.nav.edgeCount);
+    bool ok = CheckNavInvalidation(&game.nav);
+
+    UnloadGame(&game);
+    UnloadLevel(&level);
+    return ok ? 0 : 2;
+}
+
+int main(int argc, char **argv)
+{
+    long long tickCount = DEFAULT_TICKS;
+    const char *levelPath = NULL;
+    const char *scriptPath = DEFAULT_SCRIPT_PATH;
+    const char *replayPath = NULL;
+    const char *recordPath = NULL;
+    int passes = 1;
+    int workers = -1;
+    bool navCheck = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) tickCount = atoll(argv[++i]);
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) levelPath = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) passes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--navchk") == 0) navCheck = true;
+        else if (argv[i][0] != '-') scriptPath = argv[i];
+        else {
+            fprintf(stderr, "usage: bench_sim [-j workers] [-n ticks] [-l level.lvl] [-o record.rpl] [script.txt]\n"
+                            "       bench_sim [-j workers] -r session.rpl [-l level.lvl] [-p passes]\n"
+                            "       bench_sim --navchk [-l level.lvl]\n");
+            return 1;
+        }
+    }
+
+    if (navCheck) return RunNavCheck((levelPath != NULL) ? levelPath : DEFAULT_LEVEL_PATH);
+    if (replayPath != NULL) {
+        printf("workers %d\n", InitJobSystem(workers));
+        int result = RunReplay(replayPath, levelPath, (passes > 0) ? passes : 1);
+        ShutdownJobSystem();
+        return result;
+    }
+    if (levelPath == NULL) levelPath = DEFAULT_LEVEL_PATH;
+
+    static InputStep steps[MAX_STEPS];
+    int stepCount = LoadInputScript(scriptPath, steps, MAX_STEPS);
+    if (stepCount == 0) return 1;
+
+    Level level;
+    if (!LoadLevel(levelPath, &level)) { fprintf(stderr, "bench_sim: cannot load %s\n", levelPath); return 1; }
+
+    printf("workers %d\n", InitJobSystem(workers));
+
+    Game game;
+    if (!InitGame(&game, &level)) {
+        fprintf(stderr, "bench_sim: cannot set up %s\n", levelPath);
+        UnloadLevel(&level);
+        return 1;
+    }
+    ResetProfile();
+
+    InputLog log = { 0 };
+
+    int step = 0, stepTick = 0;
+    long long restarts = 0;
+    double start = GetProfileTime();
+
+    for (long long tick = 0; tick < tickCount; tick++) {
+        const GameInput *input = &steps[step].input;
+        if (input->restart && (IsGameWon(&game) || IsGameOver(&game))) restarts++;
+        if (recordPath != NULL) RecordInput(&log, input);
+        UpdateGame(&game, input);
+
+        if (++stepTick >= steps[step].ticks) {
+            stepTick = 0;
+            step = (step + 1) % stepCount;
+        }
+    }
+
+    double elapsed = GetProfileTime() - start;
+
+    printf("level   %s (%d platforms, %d after merging)\n", levelPath, level.header->platformCount, game.platformCount);
+    printf("nav     %d spans, %d edges, %lld searches, %lld cache hits\n", game.nav.spanCount, game.nav.edgeCount,
+           game.nav.searches, game.nav.cacheHits);
+    printf("shots   %d cannons, %d projectiles live, %d at most\n", level.header->cannonCount, game.projectiles.count,
+           game.projectiles.highWater);
+    printf("script  %s (%d steps)\n", scriptPath, stepCount);
+    PrintRate(tickCount, elapsed);
+    printf("state   x=%.2f y=%.2f score=%d lives=%d restarts=%lld hash=%08x\n",
+           game.player.x, game.player.y, game.score, game.lives, restarts, HashGameState(&game));
+    PrintProfile();
+
+    if (recordPath != NULL) {
+        if (SaveInputLog(&log, recordPath, &level, levelPath, &game)) printf("\nrecorded %s\n", recordPath);
+        else if (log.failed) fprintf(stderr, "bench_sim: out of memory after %d ticks, %s not written\n", log.count, recordPath);
+        else fprintf(stderr, "bench_sim: cannot write %s\n", recordPath);
+        FreeInputLog(&log);
+    }
+
+    UnloadGame(&game);
+    UnloadLevel(&level);
+    ShutdownJobSystem();
+    return 0;
+}
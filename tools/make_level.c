@@ -0,0 +1,384 @@
+// Level converter: turns a readable text level (see levels/level1.txt)
+// into the binary .lvl format that the game memory-maps.
+//   make_level <input.txt> <output.lvl>
+#include "../level.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Terrain (32x32).png is 19 tiles wide
+#define TERRAIN_TILESET_COLUMNS 19
+
+typedef struct {
+    Rectangle rect;
+    unsigned char kind;     // PlatformKind
+} SourcePlatform;
+
+// A block of cells filled from one 'tiles' line
+typedef struct {
+    int layer;
+    int col, row;
+    int cols, rows;
+    int tile;
+} TileFill;
+
+typedef struct {
+    SourcePlatform *platforms;
+    int platformCount;
+    Vector2 *diamonds;
+    int diamondCount;
+    LevelSpikeHead *spikeHeads;
+    int spikeHeadCount;
+    LevelEnemy *enemies;
+    int enemyCount;
+    LevelCannon *cannons;
+    int cannonCount;
+    TileFill *tileFills;
+    int tileFillCount;
+} LevelSource;
+
+// Names of the EnemyKinds in level sources
+static const char *enemyKindNames[ENEMY_KIND_COUNT] = {
+    [ENEMY_KING_PIG]   = "king",
+    [ENEMY_PIG]        = "pig",
+    [ENEMY_BOX_PIG]    = "box",
+    [ENEMY_BOMB_PIG]   = "bomb",
+    [ENEMY_HIDING_PIG] = "hide",
+};
+
+static void *Append(void *array, int *count, size_t elementSize)
+{
+    array = realloc(array, (*count + 1)*elementSize);
+    if (array == NULL) { fprintf(stderr, "make_level: out of memory\n"); exit(1); }
+    (*count)++;
+    return array;
+}
+
+static float GetX(const void *items, int i, size_t elementSize, size_t xOffset)
+{
+    float x;
+    memcpy(&x, (const unsigned char *)items + i*elementSize + xOffset, sizeof(float));
+    return x;
+}
+
+typedef struct {
+    float x;
+    int index;
+} SortKey;
+
+static int CompareKeys(const void *a, const void *b)
+{
+    const SortKey *ka = a, *kb = b;
+    if (ka->x != kb->x) return (ka->x < kb->x) ? -1 : 1;
+    return ka->index - kb->index;
+}
+
+// Stable sort of count elements by the float at xOffset inside each one,
+// so entities keep their source order within a column
+static void SortByX(void *items, int count, size_t elementSize, size_t xOffset)
+{
+    SortKey *keys = malloc((count + 1)*sizeof(SortKey));
+    unsigned char *sorted = malloc((count + 1)*elementSize);
+    if (keys == NULL || sorted == NULL) { fprintf(stderr, "make_level: out of memory\n"); exit(1); }
+
+    const unsigned char *bytes = items;
+    for (int i = 0; i < count; i++) keys[i] = (SortKey){ GetX(items, i, elementSize, xOffset), i };
+    qsort(keys, count, sizeof(SortKey), CompareKeys);
+    for (int i = 0; i < count; i++) memcpy(sorted + i*elementSize, bytes + keys[i].index*elementSize, elementSize);
+    memcpy(items, sorted, count*elementSize);
+
+    free(keys);
+    free(sorted);
+}
+
+static int GetChunk(float x, int chunkCount)
+{
+    int chunk = (int)floorf(x/LEVEL_CHUNK_WIDTH);
+    return (chunk < 0) ? 0 : (chunk >= chunkCount) ? chunkCount - 1 : chunk;
+}
+
+// first[c] is the index of the first sorted element whose x lies in chunk c
+// or later, for all chunkCount + 1 entries of the chunk table
+static int *BuildChunkRanges(int chunkCount, const void *items, int count, size_t elementSize, size_t xOffset, int base)
+{
+    int *first = malloc((chunkCount + 1)*sizeof(int));
+    if (first == NULL) { fprintf(stderr, "make_level: out of memory\n"); exit(1); }
+
+    int i = 0;
+    for (int c = 0; c <= chunkCount; c++) {
+        while (i < count && GetChunk(GetX(items, i, elementSize, xOffset), chunkCount) < c) i++;
+        first[c] = base + i;
+    }
+    return first;
+}
+
+// Fill the tile grids (column-major). A terrain block is drawn as a
+// nine-slice: tile is the top-left of a 3x3 group in the tileset, edges and
+// corners of the block take the matching border tiles.
+static void FillTiles(unsigned char **tiles, int tileCols, int tileRows, const TileFill *fill)
+{
+    for (int c = 0; c < fill->cols; c++) {
+        for (int r = 0; r < fill->rows; r++) {
+            int col = fill->col + c, row = fill->row + r;
+            if (col < 0 || row < 0 || col >= tileCols || row >= tileRows) continue;
+
+            int tile = fill->tile;
+            if (fill->layer == TILE_LAYER_TERRAIN) {
+                int dx = (c == 0) ? 0 : (c == fill->cols - 1) ? 2 : 1;
+                int dy = (r == 0) ? 0 : (r == fill->rows - 1) ? 2 : 1;
+                tile += dy*TERRAIN_TILESET_COLUMNS + dx;
+            }
+            tiles[fill->layer][col*tileRows + row] = (unsigned char)(tile + 1);
+        }
+    }
+}
+
+// A terrain tile with nothing above it
+static bool IsTopTile(const unsigned char *terrain, int tileRows, int col, int row)
+{
+    return terrain[col*tileRows + row] && (row == 0 || !terrain[col*tileRows + row - 1]);
+}
+
+// Collision from the terrain grid: every horizontal run of tiles with
+// nothing above becomes one walkable span, whatever its length
+static void AddTerrainSpans(LevelSource *src, const unsigned char *terrain, int tileCols, int tileRows)
+{
+    for (int row = 0; row < tileRows; row++) {
+        for (int col = 0; col < tileCols;) {
+            if (!IsTopTile(terrain, tileRows, col, row)) { col++; continue; }
+
+            int start = col;
+            while (col < tileCols && IsTopTile(terrain, tileRows, col, row)) col++;
+
+            src->platforms = Append(src->platforms, &src->platformCount, sizeof(SourcePlatform));
+            src->platforms[src->platformCount - 1] = (SourcePlatform){
+                { start*TILE_SIZE, row*TILE_SIZE, (col - start)*TILE_SIZE, TILE_SIZE }, PLATFORM_TERRAIN
+            };
+        }
+    }
+}
+
+// Write a byte table padded to 4 bytes, so the next table stays aligned
+static void WritePadded(const void *data, int size, FILE *out)
+{
+    static const unsigned char zeros[4] = { 0 };
+    fwrite(data, 1, size, out);
+    fwrite(zeros, 1, (4 - size%4)%4, out);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: make_level <input.txt> <output.lvl>\n");
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "r");
+    if (in == NULL) { fprintf(stderr, "make_level: cannot open %s\n", argv[1]); return 1; }
+
+    LevelHeader header = { .magic = LEVEL_MAGIC, .version = LEVEL_VERSION };
+    LevelSource src = { 0 };
+    bool hasGround = false;
+    float groundHeight = 0;
+
+    char line[512];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char keyword[32];
+        if (sscanf(line, "%31s", keyword) != 1) continue;
+
+        const char *args = strstr(line, keyword) + strlen(keyword);
+        int expected = 0, parsed = 0;
+
+        if (strcmp(keyword, "world") == 0) {
+            expected = 2;
+            parsed = sscanf(args, "%f %f", &header.worldWidth, &header.worldHeight);
+        } else if (strcmp(keyword, "spawn") == 0) {
+            expected = 2;
+            parsed = sscanf(args, "%f %f", &header.spawn.x, &header.spawn.y);
+        } else if (strcmp(keyword, "ground") == 0) {
+            expected = 2;
+            parsed = sscanf(args, "%f %f", &header.groundY, &groundHeight);
+            hasGround = true;
+        } else if (strcmp(keyword, "platform") == 0) {
+            src.platforms = Append(src.platforms, &src.platformCount, sizeof(SourcePlatform));
+            SourcePlatform *p = &src.platforms[src.platformCount - 1];
+            p->kind = PLATFORM_SPRITE;
+            expected = 4;
+            parsed = sscanf(args, "%f %f %f %f", &p->rect.x, &p->rect.y, &p->rect.width, &p->rect.height);
+        } else if (strcmp(keyword, "tiles") == 0) {
+            src.tileFills = Append(src.tileFills, &src.tileFillCount, sizeof(TileFill));
+            TileFill *t = &src.tileFills[src.tileFillCount - 1];
+            char layer[16] = "";
+            expected = 6;
+            parsed = sscanf(args, "%15s %i %i %i %i %i", layer, &t->col, &t->row, &t->cols, &t->rows, &t->tile);
+            if (strcmp(layer, "terrain") == 0) t->layer = TILE_LAYER_TERRAIN;
+            else if (strcmp(layer, "decor") == 0) t->layer = TILE_LAYER_DECORATIONS;
+            else if (parsed == expected) {
+                fprintf(stderr, "%s:%i: unknown tile layer '%s'\n", argv[1], lineNumber, layer);
+                return 1;
+            }
+        } else if (strcmp(keyword, "diamond") == 0) {
+            src.diamonds = Append(src.diamonds, &src.diamondCount, sizeof(Vector2));
+            Vector2 *d = &src.diamonds[src.diamondCount - 1];
+            expected = 2;
+            parsed = sscanf(args, "%f %f", &d->x, &d->y);
+        } else if (strcmp(keyword, "spike") == 0) {
+            src.spikeHeads = Append(src.spikeHeads, &src.spikeHeadCount, sizeof(LevelSpikeHead));
+            LevelSpikeHead *s = &src.spikeHeads[src.spikeHeadCount - 1];
+            expected = 3;
+            parsed = sscanf(args, "%f %f %f", &s->x, &s->y, &s->minY);
+        } else if (strcmp(keyword, "enemy") == 0) {
+            src.enemies = Append(src.enemies, &src.enemyCount, sizeof(LevelEnemy));
+            LevelEnemy *e = &src.enemies[src.enemyCount - 1];
+            char kind[16] = "";
+            expected = 3;
+            parsed = sscanf(args, "%15s %f %f", kind, &e->x, &e->y);
+            e->kind = -1;
+            for (int k = 0; k < ENEMY_KIND_COUNT; k++) {
+                if (strcmp(kind, enemyKindNames[k]) == 0) e->kind = k;
+            }
+            if (e->kind < 0 && parsed == expected) {
+                fprintf(stderr, "%s:%i: unknown enemy '%s'\n", argv[1], lineNumber, kind);
+                return 1;
+            }
+        } else if (strcmp(keyword, "cannon") == 0) {
+            src.cannons = Append(src.cannons, &src.cannonCount, sizeof(LevelCannon));
+            LevelCannon *c = &src.cannons[src.cannonCount - 1];
+            char facing[16] = "";
+            expected = 4;
+            parsed = sscanf(args, "%f %f %15s %f", &c->x, &c->y, facing, &c->period);
+            c->facing = (strcmp(facing, "left") == 0) ? -1 : (strcmp(facing, "right") == 0) ? 1 : 0;
+            if (parsed == expected && (c->facing == 0 || c->period <= 0.0f)) {
+                fprintf(stderr, "%s:%i: cannon expects left or right and a period > 0\n", argv[1], lineNumber);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "%s:%i: unknown keyword '%s'\n", argv[1], lineNumber, keyword);
+            return 1;
+        }
+
+        if (parsed != expected) {
+            fprintf(stderr, "%s:%i: '%s' expects %i values\n", argv[1], lineNumber, keyword, expected);
+            return 1;
+        }
+    }
+    fclose(in);
+
+    if (header.worldWidth <= 0 || header.worldHeight <= 0) {
+        fprintf(stderr, "make_level: missing 'world <width> <height>'\n");
+        return 1;
+    }
+
+    // Tile layers, and the walkable spans of the terrain
+    int tileCols = (int)ceilf(header.worldWidth/TILE_SIZE);
+    int tileRows = (int)ceilf(header.worldHeight/TILE_SIZE);
+    unsigned char *tiles[TILE_LAYER_COUNT];
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) {
+        tiles[layer] = calloc(tileCols*tileRows, 1);
+        if (tiles[layer] == NULL) { fprintf(stderr, "make_level: out of memory\n"); return 1; }
+    }
+    for (int i = 0; i < src.tileFillCount; i++) FillTiles(tiles, tileCols, tileRows, &src.tileFills[i]);
+    AddTerrainSpans(&src, tiles[TILE_LAYER_TERRAIN], tileCols, tileRows);
+
+    // The ground is the first platform and spans the whole world
+    int platformCount = src.platformCount + (hasGround ? 1 : 0);
+    int groundCount = hasGround ? 1 : 0;
+
+    // Sort every table by x and record where each chunk's range starts
+    int chunkCount = (int)ceilf(header.worldWidth/LEVEL_CHUNK_WIDTH);
+    SortByX(src.platforms, src.platformCount, sizeof(SourcePlatform), offsetof(SourcePlatform, rect.x));
+    SortByX(src.diamonds, src.diamondCount, sizeof(Vector2), offsetof(Vector2, x));
+    SortByX(src.spikeHeads, src.spikeHeadCount, sizeof(LevelSpikeHead), offsetof(LevelSpikeHead, x));
+    SortByX(src.enemies, src.enemyCount, sizeof(LevelEnemy), offsetof(LevelEnemy, x));
+    SortByX(src.cannons, src.cannonCount, sizeof(LevelCannon), offsetof(LevelCannon, x));
+
+    int *platformFirst = BuildChunkRanges(chunkCount, src.platforms, src.platformCount, sizeof(SourcePlatform),
+                                          offsetof(SourcePlatform, rect.x), groundCount);
+    int *diamondFirst = BuildChunkRanges(chunkCount, src.diamonds, src.diamondCount, sizeof(Vector2),
+                                         offsetof(Vector2, x), 0);
+    int *spikeHeadFirst = BuildChunkRanges(chunkCount, src.spikeHeads, src.spikeHeadCount, sizeof(LevelSpikeHead),
+                                           offsetof(LevelSpikeHead, x), 0);
+    int *enemyFirst = BuildChunkRanges(chunkCount, src.enemies, src.enemyCount, sizeof(LevelEnemy),
+                                       offsetof(LevelEnemy, x), 0);
+    int *cannonFirst = BuildChunkRanges(chunkCount, src.cannons, src.cannonCount, sizeof(LevelCannon),
+                                        offsetof(LevelCannon, x), 0);
+
+    LevelChunk *chunks = malloc((chunkCount + 1)*sizeof(LevelChunk));
+    if (chunks == NULL) { fprintf(stderr, "make_level: out of memory\n"); return 1; }
+    for (int c = 0; c <= chunkCount; c++)
+        chunks[c] = (LevelChunk){ platformFirst[c], diamondFirst[c], spikeHeadFirst[c], enemyFirst[c], cannonFirst[c] };
+    free(platformFirst);
+    free(diamondFirst);
+    free(spikeHeadFirst);
+    free(enemyFirst);
+    free(cannonFirst);
+
+    header.platformCount = platformCount;
+    header.diamondCount = src.diamondCount;
+    header.spikeHeadCount = src.spikeHeadCount;
+    header.enemyCount = src.enemyCount;
+    header.cannonCount = src.cannonCount;
+    header.platformOffset = sizeof(LevelHeader);
+    header.diamondOffset = header.platformOffset + platformCount*sizeof(Rectangle);
+    header.spikeHeadOffset = header.diamondOffset + src.diamondCount*sizeof(Vector2);
+    header.enemyOffset = header.spikeHeadOffset + src.spikeHeadCount*sizeof(LevelSpikeHead);
+    header.cannonOffset = header.enemyOffset + src.enemyCount*sizeof(LevelEnemy);
+    header.chunkCount = chunkCount;
+    header.chunkOffset = header.cannonOffset + src.cannonCount*sizeof(LevelCannon);
+    header.platformKindOffset = header.chunkOffset + (chunkCount + 1)*sizeof(LevelChunk);
+    header.tileCols = tileCols;
+    header.tileRows = tileRows;
+    header.tileOffset[0] = header.platformKindOffset + ((platformCount + 3) & ~3);
+    for (int layer = 1; layer < TILE_LAYER_COUNT; layer++)
+        header.tileOffset[layer] = header.tileOffset[layer - 1] + ((tileCols*tileRows + 3) & ~3);
+
+    unsigned char *kinds = malloc(platformCount + 1);
+    Rectangle *rects = malloc((platformCount + 1)*sizeof(Rectangle));
+    if (kinds == NULL || rects == NULL) { fprintf(stderr, "make_level: out of memory\n"); return 1; }
+    if (hasGround) {
+        rects[0] = (Rectangle){ 0, header.groundY, header.worldWidth, groundHeight };
+        kinds[0] = PLATFORM_GROUND;
+    }
+    for (int i = 0; i < src.platformCount; i++) {
+        rects[groundCount + i] = src.platforms[i].rect;
+        kinds[groundCount + i] = src.platforms[i].kind;
+    }
+
+    FILE *out = fopen(argv[2], "wb");
+    if (out == NULL) { fprintf(stderr, "make_level: cannot write %s\n", argv[2]); return 1; }
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(rects, sizeof(Rectangle), platformCount, out);
+    fwrite(src.diamonds, sizeof(Vector2), src.diamondCount, out);
+    fwrite(src.spikeHeads, sizeof(LevelSpikeHead), src.spikeHeadCount, out);
+    fwrite(src.enemies, sizeof(LevelEnemy), src.enemyCount, out);
+    fwrite(src.cannons, sizeof(LevelCannon), src.cannonCount, out);
+    fwrite(chunks, sizeof(LevelChunk), chunkCount + 1, out);
+    WritePadded(kinds, platformCount, out);
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) WritePadded(tiles[layer], tileCols*tileRows, out);
+    bool ok = (fclose(out) == 0);
+
+    printf("make_level: %s -> %s (%i platforms, %i diamonds, %i spike heads, %i enemies, %i cannons, %i chunks, %ix%i tiles)\n",
+           argv[1], argv[2], platformCount, src.diamondCount, src.spikeHeadCount, src.enemyCount, src.cannonCount, chunkCount,
+           tileCols, tileRows);
+
+    free(src.platforms);
+    free(src.diamonds);
+    free(src.spikeHeads);
+    free(src.enemies);
+    free(src.cannons);
+    free(src.tileFills);
+    free(chunks);
+    free(kinds);
+    free(rects);
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) free(tiles[layer]);
+    return ok ? 0 : 1;
+}